@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "PipeConfig.hxx"
+
+/*
+ * \brief Common helpers shared by all benchmark executables
+ */
+namespace bench {
+
+/*
+ * \brief Current monotonic time in nanoseconds
+ */
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * \brief Consumed CPU time (user + system) of the whole process in nanoseconds
+ */
+inline uint64_t cpuNs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ull + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ull;
+}
+
+/*
+ * \brief Encode a send timestamp into a payload of the given size
+ * \param timestamp Timestamp in nanoseconds
+ * \param size Total payload size, padded with filler characters
+ */
+inline std::string makePayload(uint64_t timestamp, size_t size) {
+    std::string payload = std::to_string(timestamp);
+    payload.push_back(';');
+    if (payload.size() < size) {
+        payload.resize(size, 'x');
+    }
+    return payload;
+}
+
+/*
+ * \brief Decode the send timestamp of a payload created by makePayload
+ * \param payload Pointer to the payload
+ */
+inline uint64_t payloadTimestamp(char const* payload) {
+    return std::strtoull(payload, nullptr, 10);
+}
+
+/*
+ * \brief Collects latency samples and computes percentiles
+ */
+class LatencyRecorder {
+public:
+    /*
+     * \brief Create recorder with preallocated space for samples
+     * \param expected Number of expected samples
+     */
+    explicit LatencyRecorder(size_t expected) {
+        m_samples.reserve(expected);
+    }
+
+    /*
+     * \brief Record a single latency sample
+     * \param ns Latency in nanoseconds
+     */
+    void record(uint64_t ns) {
+        m_samples.push_back(ns);
+    }
+
+    /*
+     * \brief Get number of recorded samples
+     */
+    size_t count() const {
+        return m_samples.size();
+    }
+
+    /*
+     * \brief Get percentile of all recorded samples in nanoseconds
+     * \param p Percentile in range [0, 100]
+     */
+    uint64_t percentile(double p) {
+        if (m_samples.empty()) {
+            return 0;
+        }
+        if (!m_sorted) {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+        size_t idx = static_cast<size_t>((p / 100.0) * (m_samples.size() - 1) + 0.5);
+        return m_samples[std::min(idx, m_samples.size() - 1)];
+    }
+
+private:
+    // All recorded samples
+    std::vector<uint64_t> m_samples;
+    // Whether samples are currently sorted
+    bool m_sorted = false;
+};
+
+/*
+ * \brief Result of a single benchmark run
+ */
+struct Result {
+    // Name of the benchmarked variant
+    std::string name;
+    // Number of processed messages
+    size_t messages;
+    // Payload size per message
+    size_t size;
+    // Wall clock time of the run
+    uint64_t wallNs;
+    // CPU time of the run (all threads)
+    uint64_t cpuNs;
+    // Latency p50, p99 and p99.9 in nanoseconds
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+/*
+ * \brief Print table header for results
+ */
+inline void printHeader() {
+    std::printf("%-20s %10s %12s %10s %10s %10s %10s %12s\n", "variant", "size", "msg/s", "MB/s", "p50[us]", "p99[us]", "p99.9[us]", "cpu[ns/msg]");
+}
+
+/*
+ * \brief Print a single result row
+ * \param result Result to print
+ */
+inline void printResult(Result const& result) {
+    double seconds = result.wallNs / 1e9;
+    double rate = seconds > 0 ? result.messages / seconds : 0;
+    std::printf("%-20s %10zu %12.0f %10.1f %10.2f %10.2f %10.2f %12.0f\n",
+        result.name.c_str(), result.size, rate, rate * result.size / 1e6,
+        result.p50 / 1e3, result.p99 / 1e3, result.p999 / 1e3,
+        result.messages > 0 ? static_cast<double>(result.cpuNs) / result.messages : 0.0);
+    std::fflush(stdout);
+}
+
+/*
+ * \brief Resident set size of the process in bytes
+ */
+inline size_t residentBytes() {
+    size_t pages = 0;
+    size_t resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/*
+ * \brief Pipe configuration from the environment that always uses the named pipe, also between threads of this process
+ */
+inline PipeConfig fifoConfig() {
+    PipeConfig config = PipeConfig::fromEnvironment();
+    config.localShortcut = false;
+    return config;
+}
+
+/*
+ * \brief Parse a numeric command line option of the form --name value
+ * \param argc Argument count
+ * \param argv Argument vector
+ * \param name Option name including leading dashes
+ * \param fallback Value used if option is missing
+ */
+inline size_t option(int argc, char* argv[], std::string const& name, size_t fallback) {
+    for (int idx = 1; idx + 1 < argc; ++idx) {
+        if (name == argv[idx]) {
+            return std::strtoull(argv[idx + 1], nullptr, 10);
+        }
+    }
+    return fallback;
+}
+
+}
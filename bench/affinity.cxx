@@ -0,0 +1,134 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+#include <deque>
+
+/*
+ * Delivers messages to a handler owned by a worker thread, once with the
+ * reader callback copying each message into a queue of the worker guarded by
+ * a mutex (the usual hop) and once with the callback registered on an
+ * Executor, whose inbox the reader fills directly. Latency is measured from
+ * the write to the handler on the worker thread.
+ *
+ * Usage: pipe-cxx-bench-affinity [--messages N] [--size BYTES] [--rate MSG_PER_S]
+ *
+ * Runs unpaced and then paced at --rate (default 50000) with a quarter of the messages.
+ */
+
+namespace {
+
+/*
+ * \brief Handler state owned by the worker thread
+ */
+struct Worker {
+    explicit Worker(size_t messages) : latencies(messages), handled(0) {}
+
+    void handle(std::string_view msg) {
+        latencies.record(bench::nowNs() - bench::payloadTimestamp(msg.data()));
+        handled.fetch_add(1, std::memory_order_release);
+    }
+
+    bench::LatencyRecorder latencies;
+    std::atomic<size_t> handled;
+};
+
+/*
+ * \brief Write paced messages and wait until the worker handled all of them
+ */
+bench::Result send(std::string const& name, UnixPipe& writer, Worker& worker, size_t messages, size_t size, size_t rate) {
+    uint64_t interval = rate > 0 ? 1000000000ull / rate : 0;
+    uint64_t cpuStart = bench::cpuNs();
+    uint64_t wallStart = bench::nowNs();
+    for (size_t idx = 0; idx < messages; ++idx) {
+        while (interval > 0 && bench::nowNs() < wallStart + idx * interval) {}
+        writer.write("data", bench::makePayload(bench::nowNs(), size));
+    }
+    while (worker.handled.load(std::memory_order_acquire) < messages) {
+        std::this_thread::yield();
+    }
+    bench::Result result;
+    result.name = rate > 0 ? name + " @" + std::to_string(rate / 1000) + "k" : name;
+    result.messages = messages;
+    result.size = size;
+    result.wallNs = bench::nowNs() - wallStart;
+    result.cpuNs = bench::cpuNs() - cpuStart;
+    result.p50 = worker.latencies.percentile(50);
+    result.p99 = worker.latencies.percentile(99);
+    result.p999 = worker.latencies.percentile(99.9);
+    return result;
+}
+
+bench::Result benchQueue(std::string const& path, size_t messages, size_t size, size_t rate) {
+    Worker worker(messages);
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::string> queue;
+    bool stop = false;
+    std::thread thread([&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ready.wait(lock, [&]() { return stop || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            std::string msg = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            worker.handle(msg);
+            lock.lock();
+        }
+    });
+    bench::Result result;
+    {
+        UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+        UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+        reader.addViewCallback("data", [&](std::string_view msg) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.emplace_back(msg);
+            }
+            ready.notify_one();
+        });
+        reader.start();
+        result = send("reader + queue", writer, worker, messages, size, rate);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    ready.notify_one();
+    thread.join();
+    return result;
+}
+
+bench::Result benchExecutor(std::string const& path, size_t messages, size_t size, size_t rate) {
+    Worker worker(messages);
+    Executor executor;
+    executor.start();
+    UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+    UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+    reader.addCallback("data", executor, [&worker](std::string_view msg) {
+        worker.handle(msg);
+    });
+    reader.start();
+    return send("executor", writer, worker, messages, size, rate);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 200000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t rate = bench::option(argc, argv, "--rate", 0);
+    std::string path = "/tmp/pipe-cxx-bench-affinity-" + std::to_string(getpid());
+
+    bench::printHeader();
+    bench::printResult(benchQueue(path, messages, size, 0));
+    bench::printResult(benchExecutor(path, messages, size, 0));
+    // Paced, so latency is not dominated by queueing
+    size_t paced = rate > 0 ? rate : 50000;
+    bench::printResult(benchQueue(path, messages / 4, size, paced));
+    bench::printResult(benchExecutor(path, messages / 4, size, paced));
+    unlink(path.c_str());
+    return 0;
+}
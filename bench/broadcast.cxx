@@ -0,0 +1,123 @@
+#include "Benchmark.hxx"
+#include "BroadcastRing.hxx"
+
+/*
+ * Delivers the same stream of timestamped messages to several readers, once
+ * through a BroadcastRing shared by all readers and once through one UnixPipe
+ * per reader written in turn. Latency percentiles are those of the slowest reader.
+ *
+ * Usage: pipe-cxx-bench-broadcast [--messages N] [--size BYTES] [--readers N]
+ */
+
+namespace {
+
+/*
+ * \brief Received messages and latency of a single reader
+ */
+struct ReaderStats {
+    std::atomic<size_t> received{0};
+    bench::LatencyRecorder latency;
+
+    explicit ReaderStats(size_t messages) : latency(messages) {}
+
+    void onMessage(char const* payload) {
+        latency.record(bench::nowNs() - bench::payloadTimestamp(payload));
+        received.fetch_add(1, std::memory_order_release);
+    }
+};
+
+/*
+ * \brief Send all messages and wait for all readers
+ */
+template<typename Send>
+bench::Result run(std::string const& name, size_t messages, size_t size, std::vector<std::unique_ptr<ReaderStats>>& readers, Send send) {
+    uint64_t cpuStart = bench::cpuNs();
+    uint64_t wallStart = bench::nowNs();
+    for (size_t idx = 0; idx < messages; ++idx) {
+        send(bench::makePayload(bench::nowNs(), size));
+    }
+    for (auto& reader : readers) {
+        while (reader->received.load(std::memory_order_acquire) < messages) {
+            std::this_thread::yield();
+        }
+    }
+    bench::Result result;
+    result.wallNs = bench::nowNs() - wallStart;
+    result.cpuNs = bench::cpuNs() - cpuStart;
+    result.name = name;
+    result.messages = messages;
+    result.size = size;
+    result.p50 = result.p99 = result.p999 = 0;
+    for (auto& reader : readers) {
+        result.p50 = std::max(result.p50, reader->latency.percentile(50));
+        result.p99 = std::max(result.p99, reader->latency.percentile(99));
+        result.p999 = std::max(result.p999, reader->latency.percentile(99.9));
+    }
+    return result;
+}
+
+bench::Result benchRing(size_t messages, size_t size, size_t count) {
+    std::string path = "/dev/shm/pipe-cxx-bench-broadcast-" + std::to_string(getpid());
+    std::vector<std::unique_ptr<ReaderStats>> stats;
+    bench::Result result;
+    {
+        BroadcastRing writer(path, PipeAccess::Write, BroadcastRing::DEFAULT_SLOTS, std::max<size_t>(BroadcastRing::DEFAULT_SLOT_SIZE, size + 64));
+        std::vector<std::unique_ptr<BroadcastRing>> readers;
+        for (size_t idx = 0; idx < count; ++idx) {
+            stats.emplace_back(new ReaderStats(messages));
+            readers.emplace_back(new BroadcastRing(path, PipeAccess::Read, BroadcastRing::DEFAULT_SLOTS, std::max<size_t>(BroadcastRing::DEFAULT_SLOT_SIZE, size + 64)));
+            ReaderStats* reader = stats.back().get();
+            readers.back()->addViewCallback("data", [reader](std::string_view msg) {
+                reader->onMessage(msg.data());
+            });
+            readers.back()->start();
+        }
+        result = run("broadcast ring", messages, size, stats, [&](std::string const& payload) {
+            writer.write("data", payload);
+        });
+    }
+    unlink(path.c_str());
+    return result;
+}
+
+bench::Result benchFifos(size_t messages, size_t size, size_t count) {
+    std::string path = "/tmp/pipe-cxx-bench-broadcast-" + std::to_string(getpid()) + "-";
+    std::vector<std::unique_ptr<ReaderStats>> stats;
+    bench::Result result;
+    {
+        std::vector<std::unique_ptr<UnixPipe>> writers;
+        std::vector<std::unique_ptr<UnixPipe>> readers;
+        for (size_t idx = 0; idx < count; ++idx) {
+            stats.emplace_back(new ReaderStats(messages));
+            writers.emplace_back(new UnixPipe(path + std::to_string(idx), PipeAccess::Write, bench::fifoConfig()));
+            readers.emplace_back(new UnixPipe(path + std::to_string(idx), PipeAccess::Read, bench::fifoConfig()));
+            ReaderStats* reader = stats.back().get();
+            readers.back()->addViewCallback("data", [reader](std::string_view msg) {
+                reader->onMessage(msg.data());
+            });
+            readers.back()->start();
+        }
+        result = run("fifo per reader", messages, size, stats, [&](std::string const& payload) {
+            for (auto& writer : writers) {
+                writer->write("data", payload);
+            }
+        });
+    }
+    for (size_t idx = 0; idx < count; ++idx) {
+        unlink((path + std::to_string(idx)).c_str());
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 200000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t readers = bench::option(argc, argv, "--readers", 4);
+
+    bench::printHeader();
+    bench::printResult(benchFifos(messages, size, readers));
+    bench::printResult(benchRing(messages, size, readers));
+    return 0;
+}
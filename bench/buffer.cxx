@@ -0,0 +1,70 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * Streams messages of one size through the named pipe with the fixed receive
+ * buffer steps of read_size (FixedBuffer) and with the buffer adapted to the
+ * frame sizes (AdaptiveBuffer).
+ * Reports throughput, CPU time, how often the receive buffer changed its size
+ * and its final size.
+ *
+ * Usage: pipe-cxx-bench-buffer [--bytes N] [--read-size BYTES]
+ */
+
+namespace {
+
+// Pipe growing its receive buffer in read_size steps
+using FixedPipe = BasicUnixPipe<PipeCodec, FixedBuffer>;
+
+template<typename Pipe>
+void run(std::string const& name, PipeConfig const& config, size_t messages, size_t size) {
+    std::string path = "/tmp/pipe-cxx-bench-buffer-" + std::to_string(getpid());
+    std::string payload(size, 'x');
+    std::atomic<size_t> received(0);
+    size_t resizes = 0;
+    size_t lastSize = 0;
+    size_t finalSize = 0;
+    {
+        Pipe writer(path, PipeAccess::Write, config);
+        Pipe reader(path, PipeAccess::Read, config);
+        // Called on the reader thread, which is the only one changing the buffer
+        reader.addViewCallback("data", [&](std::string_view) {
+            if (reader.bufferSize() != lastSize) {
+                lastSize = reader.bufferSize();
+                ++resizes;
+            }
+            received.fetch_add(1, std::memory_order_release);
+        });
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write("data", payload);
+        }
+        while (received.load(std::memory_order_acquire) < messages) {
+            std::this_thread::yield();
+        }
+        double seconds = (bench::nowNs() - wallStart) / 1e9;
+        finalSize = reader.bufferSize();
+        std::printf("%-12s %8zu %12.0f %10.1f %12.1f %8zu %12zu\n", name.c_str(), size, messages / seconds, messages * size / seconds / 1e6,
+            static_cast<double>(bench::cpuNs() - cpuStart) / messages, resizes, finalSize);
+        std::fflush(stdout);
+    }
+    unlink(path.c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t bytes = bench::option(argc, argv, "--bytes", 256 << 20);
+    PipeConfig config = bench::fifoConfig();
+    config.readSize = bench::option(argc, argv, "--read-size", config.readSize);
+
+    std::printf("%-12s %8s %12s %10s %12s %8s %12s\n", "variant", "size", "msg/s", "MB/s", "cpu[ns/msg]", "resizes", "buffer[B]");
+    for (size_t size : { 64, 1024, 65536, 1 << 20 }) {
+        size_t messages = std::max<size_t>(bytes / size, 256);
+        run<FixedPipe>("fixed", config, messages, size);
+        run<UnixPipe>("adaptive", config, messages, size);
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * Stress harness for the overload behavior of UnixPipe. A writer thread sends
+ * messages at a base rate plus optional bursts while the consumer is slowed
+ * down by callback delays and periodic stalls and the CPU is oversubscribed by
+ * hog threads. Every interval throughput, write failures (pipe full), receive
+ * buffer size and process RSS are reported. Limits turn the run into a check.
+ *
+ * Usage: pipe-cxx-bench-chaos [--duration S] [--interval MS] [--size BYTES] [--rate MSG_PER_SEC]
+ *                             [--delay-us US] [--delay-every N] [--stall-ms MS] [--stall-every-ms MS]
+ *                             [--hogs N] [--burst N] [--burst-every-ms MS]
+ *                             [--max-buffer BYTES] [--max-failures N]
+ */
+
+namespace {
+
+/*
+ * \brief Sleep or spin until the given point in time
+ */
+void waitUntil(uint64_t due) {
+    uint64_t now = bench::nowNs();
+    if (due > now + 200000) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - 100000));
+    }
+    while (bench::nowNs() < due) {}
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t duration = bench::option(argc, argv, "--duration", 10);
+    size_t interval = bench::option(argc, argv, "--interval", 1000);
+    size_t size = bench::option(argc, argv, "--size", 256);
+    size_t rate = bench::option(argc, argv, "--rate", 50000);
+    size_t delayUs = bench::option(argc, argv, "--delay-us", 0);
+    size_t delayEvery = std::max<size_t>(1, bench::option(argc, argv, "--delay-every", 1));
+    size_t stallMs = bench::option(argc, argv, "--stall-ms", 0);
+    size_t stallEveryMs = bench::option(argc, argv, "--stall-every-ms", 0);
+    size_t hogs = bench::option(argc, argv, "--hogs", 0);
+    size_t burst = bench::option(argc, argv, "--burst", 0);
+    size_t burstEveryMs = bench::option(argc, argv, "--burst-every-ms", 0);
+    size_t maxBuffer = bench::option(argc, argv, "--max-buffer", 0);
+    size_t maxFailures = bench::option(argc, argv, "--max-failures", 0);
+
+    std::string name = "/tmp/pipe-cxx-chaos-" + std::to_string(getpid());
+    std::atomic<bool> running(true);
+    std::atomic<size_t> sent(0);
+    std::atomic<size_t> failed(0);
+    std::atomic<size_t> received(0);
+    size_t peakBuffer = 0;
+    size_t totalFailures = 0;
+    {
+        UnixPipe writer(name, PipeAccess::Write, bench::fifoConfig());
+        UnixPipe reader(name, PipeAccess::Read, bench::fifoConfig());
+
+        // Slow consumer: delay every n-th callback and stall periodically
+        uint64_t nextStall = bench::nowNs() + stallEveryMs * 1000000ull;
+        reader.addCallback("chaos", [&](std::string const&) {
+            size_t count = received.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (delayUs > 0 && count % delayEvery == 0) {
+                waitUntil(bench::nowNs() + delayUs * 1000ull);
+            }
+            if (stallEveryMs > 0 && bench::nowNs() >= nextStall) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+                nextStall = bench::nowNs() + stallEveryMs * 1000000ull;
+            }
+        });
+        reader.start();
+
+        // Oversubscribe the CPU
+        std::vector<std::thread> hogThreads;
+        for (size_t idx = 0; idx < hogs; ++idx) {
+            hogThreads.emplace_back([&]() {
+                volatile uint64_t sink = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    sink = sink + 1;
+                }
+            });
+        }
+
+        // Writer with base rate and periodic bursts, full pipes count as failures
+        std::thread writerThread([&]() {
+            std::string payload(size, 'x');
+            uint64_t start = bench::nowNs();
+            uint64_t nextBurst = start + burstEveryMs * 1000000ull;
+            size_t paced = 0;
+            auto send = [&]() {
+                if (writer.tryWrite("chaos", payload)) {
+                    sent.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            };
+            while (running.load(std::memory_order_relaxed)) {
+                if (burst > 0 && burstEveryMs > 0 && bench::nowNs() >= nextBurst) {
+                    for (size_t idx = 0; idx < burst; ++idx) {
+                        send();
+                    }
+                    nextBurst += burstEveryMs * 1000000ull;
+                }
+                if (rate > 0) {
+                    waitUntil(start + ++paced * 1000000000ull / rate);
+                }
+                send();
+            }
+        });
+
+        // Report every interval
+        std::printf("%8s %12s %12s %12s %14s %14s\n", "time[s]", "sent/s", "recv/s", "failed/s", "buffer[B]", "rss[B]");
+        size_t lastSent = 0;
+        size_t lastReceived = 0;
+        uint64_t start = bench::nowNs();
+        uint64_t end = start + duration * 1000000000ull;
+        for (uint64_t due = start + interval * 1000000ull; due <= end; due += interval * 1000000ull) {
+            waitUntil(due);
+            size_t nowSent = sent.load(std::memory_order_relaxed);
+            size_t nowReceived = received.load(std::memory_order_relaxed);
+            size_t nowFailed = failed.exchange(0, std::memory_order_relaxed);
+            double seconds = interval / 1e3;
+            peakBuffer = std::max(peakBuffer, reader.bufferSize());
+            totalFailures += nowFailed;
+            std::printf("%8.1f %12.0f %12.0f %12.0f %14zu %14zu\n", (due - start) / 1e9,
+                (nowSent - lastSent) / seconds, (nowReceived - lastReceived) / seconds, nowFailed / seconds,
+                reader.bufferSize(), bench::residentBytes());
+            std::fflush(stdout);
+            lastSent = nowSent;
+            lastReceived = nowReceived;
+        }
+        running = false;
+        writerThread.join();
+        for (auto& thread : hogThreads) {
+            thread.join();
+        }
+    }
+    unlink(name.c_str());
+
+    // Check limits
+    int result = 0;
+    if (maxBuffer > 0 && peakBuffer > maxBuffer) {
+        std::printf("Receive buffer grew to %zu bytes, limit is %zu.\n", peakBuffer, maxBuffer);
+        result = 1;
+    }
+    if (maxFailures > 0 && totalFailures > maxFailures) {
+        std::printf("%zu writes failed, limit is %zu.\n", totalFailures, maxFailures);
+        result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,78 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * Measures framing, escaping, parsing and dispatch of UnixPipe without the
+ * kernel in the way: the same workload runs over the named pipe and over the
+ * in-memory transport, whose reader spins instead of sleeping. Payloads with
+ * embedded frame tags additionally exercise escaping and unescaping. The lean
+ * variant compiles escaping, writer locking and statistics out of the pipe
+ * through its policies.
+ *
+ * Usage: pipe-cxx-bench-codec [--messages N]
+ */
+
+namespace {
+
+/*
+ * \brief Payload of the given size, optionally containing a frame tag every 64 bytes
+ */
+std::string makePayload(size_t size, bool tags) {
+    std::string payload(size, 'x');
+    for (size_t pos = 0; tags && pos + std::strlen(UnixPipe::PREFIX) <= size; pos += 64) {
+        payload.replace(pos, std::strlen(UnixPipe::PREFIX), UnixPipe::PREFIX);
+    }
+    return payload;
+}
+
+// Pipe whose writers never send tags, written by a single thread and without instrumentation
+using LeanPipe = BasicUnixPipe<RawCodec, AdaptiveBuffer, NoLocking, NoInstrumentation>;
+
+template<typename Pipe = UnixPipe>
+void run(std::string const& name, PipeConfig const& config, size_t messages, size_t size, bool tags) {
+    std::string path = "/tmp/pipe-cxx-bench-codec-" + std::to_string(getpid());
+    std::string payload = makePayload(size, tags);
+    std::atomic<size_t> received(0);
+    {
+        Pipe writer(path, PipeAccess::Write, config);
+        Pipe reader(path, PipeAccess::Read, config);
+        reader.addViewCallback("data", [&received](std::string_view) {
+            received.fetch_add(1, std::memory_order_release);
+        });
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write("data", payload);
+        }
+        while (received.load(std::memory_order_acquire) < messages) {
+            std::this_thread::yield();
+        }
+        double seconds = (bench::nowNs() - wallStart) / 1e9;
+        std::printf("%-20s %8zu %12.0f %10.1f %12.1f\n", name.c_str(), size, messages / seconds, messages * size / seconds / 1e6,
+            static_cast<double>(bench::cpuNs() - cpuStart) / messages);
+        std::fflush(stdout);
+    }
+    if (config.transport == TransportType::Fifo) {
+        unlink(path.c_str());
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 200000);
+
+    PipeConfig memory = bench::fifoConfig();
+    memory.transport = TransportType::Memory;
+    memory.spinBudget = std::numeric_limits<size_t>::max();
+
+    std::printf("%-20s %8s %12s %10s %12s\n", "variant", "size", "msg/s", "MB/s", "cpu[ns/msg]");
+    for (size_t size : { 16, 128, 1024, 8192 }) {
+        run("fifo", bench::fifoConfig(), messages, size, false);
+        run("memory", memory, messages, size, false);
+        run("memory escaped", memory, messages, size, true);
+        run<LeanPipe>("memory lean", memory, messages, size, false);
+    }
+    return 0;
+}
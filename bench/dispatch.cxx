@@ -0,0 +1,80 @@
+#include "Benchmark.hxx"
+#include "InlineFunction.hxx"
+#include "UnixPipe.hxx"
+
+#include <array>
+
+/*
+ * Measures the callback dispatch overhead of std::function against the inline
+ * callable used by UnixPipe. For captures of different sizes a set of handlers
+ * is constructed and then invoked round robin like the reader does per message.
+ *
+ * Usage: pipe-cxx-bench-dispatch [--calls N] [--handlers N]
+ */
+
+namespace {
+
+// Prevents the compiler from removing the benchmarked calls
+size_t g_sink = 0;
+
+/*
+ * \brief Handler capturing Size bytes of state
+ */
+template<size_t Size>
+struct Handler {
+    std::array<size_t, Size / sizeof(size_t)> state;
+
+    void operator()(std::string const& msg) const {
+        g_sink += msg.size() + state[0];
+    }
+};
+
+/*
+ * \brief Construct and invoke handlers of type Function wrapping Handler<Size>
+ * \param name Name printed in the result table
+ * \param calls Number of invocations
+ * \param handlers Number of distinct handlers
+ */
+template<typename Function, size_t Size>
+void run(std::string const& name, size_t calls, size_t handlers) {
+    std::string msg(64, 'x');
+    // Construction, includes possible heap allocation
+    std::vector<Function> functions;
+    functions.reserve(handlers);
+    uint64_t constructStart = bench::nowNs();
+    for (size_t idx = 0; idx < handlers; ++idx) {
+        Handler<Size> handler;
+        handler.state.fill(idx);
+        functions.emplace_back(handler);
+    }
+    uint64_t constructNs = bench::nowNs() - constructStart;
+    // Invocation round robin over all handlers
+    uint64_t callStart = bench::nowNs();
+    for (size_t idx = 0; idx < calls; ++idx) {
+        functions[idx % handlers](msg);
+    }
+    uint64_t callNs = bench::nowNs() - callStart;
+    std::printf("%-28s %10zu %14.2f %14.2f\n", name.c_str(), Size,
+        static_cast<double>(constructNs) / handlers, static_cast<double>(callNs) / calls);
+    std::fflush(stdout);
+}
+
+template<size_t Size>
+void compare(size_t calls, size_t handlers) {
+    run<std::function<void(std::string const&)>, Size>("std::function", calls, handlers);
+    run<UnixPipe::Callback, Size>("UnixPipe::Callback", calls, handlers);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t calls = bench::option(argc, argv, "--calls", 50000000);
+    size_t handlers = bench::option(argc, argv, "--handlers", 64);
+
+    std::printf("%-28s %10s %14s %14s\n", "callable", "capture[B]", "construct[ns]", "call[ns]");
+    compare<8>(calls, handlers);
+    compare<16>(calls, handlers);
+    compare<32>(calls, handlers);
+    compare<UnixPipe::CALLBACK_CAPACITY>(calls, handlers);
+    return g_sink == 0;
+}
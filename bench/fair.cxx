@@ -0,0 +1,104 @@
+#include "Benchmark.hxx"
+#include "PipeReactor.hxx"
+
+/*
+ * Serves a bulk pipe, whose writer sends as fast as the pipe takes it and whose
+ * callback spends --work-ns per message, together with paced low-rate pipes on
+ * one PipeReactor. Reports the latency of the low-rate pipes and the bulk
+ * throughput for different quanta of the deficit round robin scheduling, and
+ * with a higher weight of the bulk pipe.
+ *
+ * Usage: pipe-cxx-bench-fair [--pipes N] [--messages N] [--rate MSG_PER_S] [--size BYTES] [--work-ns NS]
+ */
+
+namespace {
+
+void run(std::string const& name, std::string const& path, size_t quantum, size_t bulkWeight, size_t pipes, size_t messages, size_t rate,
+        size_t size, uint64_t workNs) {
+    PipeConfig config = bench::fifoConfig();
+    config.reactorQuantumBytes = quantum;
+    PipeConfig bulkConfig = config;
+    bulkConfig.reactorWeight = bulkWeight;
+    // Deep backlog, so a turn without quantum would process a lot
+    bulkConfig.capacity = 1024 * 1024;
+
+    bench::LatencyRecorder latencies(messages);
+    std::atomic<size_t> received(0);
+    std::atomic<size_t> bulkReceived(0);
+    std::vector<std::unique_ptr<UnixPipe>> readers;
+    std::vector<std::unique_ptr<UnixPipe>> writers;
+    PipeReactor reactor;
+    for (size_t idx = 0; idx < pipes; ++idx) {
+        std::string pipePath = path + "-" + std::to_string(idx);
+        readers.emplace_back(new UnixPipe(pipePath, PipeAccess::Read, config));
+        readers.back()->addViewCallback("tick", [&](std::string_view msg) {
+            latencies.record(bench::nowNs() - bench::payloadTimestamp(msg.data()));
+            received.fetch_add(1, std::memory_order_release);
+        });
+        reactor.add(*readers.back());
+        writers.emplace_back(new UnixPipe(pipePath, PipeAccess::Write, config));
+    }
+    std::string bulkPath = path + "-bulk";
+    UnixPipe bulkReader(bulkPath, PipeAccess::Read, bulkConfig);
+    bulkReader.addViewCallback("bulk", [&](std::string_view) {
+        uint64_t until = bench::nowNs() + workNs;
+        while (bench::nowNs() < until) {}
+        bulkReceived.fetch_add(1, std::memory_order_relaxed);
+    });
+    reactor.add(bulkReader);
+    reactor.start();
+
+    std::atomic<bool> stop(false);
+    std::thread bulkWriter([&]() {
+        UnixPipe writer(bulkPath, PipeAccess::Write, bulkConfig);
+        std::string payload(size, 'b');
+        while (!stop.load(std::memory_order_acquire)) {
+            writer.write("bulk", payload);
+        }
+    });
+    // Let the bulk pipe fill up before the low-rate messages start
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    uint64_t interval = 1000000000ull / rate;
+    uint64_t wallStart = bench::nowNs();
+    size_t bulkStart = bulkReceived.load(std::memory_order_relaxed);
+    for (size_t idx = 0; idx < messages; ++idx) {
+        while (bench::nowNs() < wallStart + idx * interval) {
+            std::this_thread::yield();
+        }
+        writers[idx % pipes]->write("tick", bench::makePayload(bench::nowNs(), 64));
+    }
+    while (received.load(std::memory_order_acquire) < messages) {
+        std::this_thread::yield();
+    }
+    double seconds = (bench::nowNs() - wallStart) / 1e9;
+    size_t bulkMessages = bulkReceived.load(std::memory_order_relaxed) - bulkStart;
+    stop.store(true, std::memory_order_release);
+    bulkWriter.join();
+
+    std::printf("%-24s %10.2f %10.2f %10.2f %12.1f\n", name.c_str(), latencies.percentile(50) / 1e3, latencies.percentile(99) / 1e3,
+        latencies.percentile(99.9) / 1e3, bulkMessages * size / seconds / 1e6);
+    std::fflush(stdout);
+    for (size_t idx = 0; idx < pipes; ++idx) {
+        unlink((path + "-" + std::to_string(idx)).c_str());
+    }
+    unlink(bulkPath.c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t pipes = bench::option(argc, argv, "--pipes", 4);
+    size_t messages = bench::option(argc, argv, "--messages", 2000);
+    size_t rate = bench::option(argc, argv, "--rate", 1000);
+    size_t size = bench::option(argc, argv, "--size", 4096);
+    uint64_t workNs = bench::option(argc, argv, "--work-ns", 1000);
+    std::string path = "/tmp/pipe-cxx-bench-fair-" + std::to_string(getpid());
+
+    std::printf("%-24s %10s %10s %10s %12s\n", "variant", "p50[us]", "p99[us]", "p99.9[us]", "bulk[MB/s]");
+    run("quantum 16 MiB", path, 16 * 1024 * 1024, 1, pipes, messages, rate, size, workNs);
+    run("quantum 64 KiB", path, 64 * 1024, 1, pipes, messages, rate, size, workNs);
+    run("quantum 8 KiB", path, 8 * 1024, 1, pipes, messages, rate, size, workNs);
+    run("quantum 8 KiB, bulk x8", path, 8 * 1024, 8, pipes, messages, rate, size, workNs);
+    return 0;
+}
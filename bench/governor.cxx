@@ -0,0 +1,120 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+#include <fcntl.h>
+
+/*
+ * Runs well-behaved pipes next to a runaway writer that announces a frame of
+ * 1 GiB and then streams its content, so the receive buffer of its reader grows
+ * without bound. Reports the peak memory accounted by the readers, the actions
+ * of the MemoryGovernor and throughput and latency of the well-behaved pipes,
+ * once without budget and once per action with --budget.
+ *
+ * Usage: pipe-cxx-bench-governor [--pipes N] [--messages N] [--size BYTES] [--runaway BYTES] [--budget BYTES]
+ */
+
+namespace {
+
+// Length announced by the runaway frame
+constexpr size_t const RUNAWAY_FRAME = size_t(1) << 30;
+
+/*
+ * \brief Stream the content of a never ending frame until stopped or the given number of bytes is written
+ */
+void runaway(std::string const& path, size_t bytes, std::atomic<bool> const& stop) {
+    // Written around the pipe object, which would wait for the paused reader
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+    std::string header;
+    PipeCodec::appendHeader(header, "bulk", RUNAWAY_FRAME);
+    std::string chunk = header + std::string(64 * 1024 - header.size(), 'x');
+    size_t written = 0;
+    while (!stop.load(std::memory_order_acquire) && written < bytes) {
+        ssize_t count = ::write(fd, chunk.data() + (written == 0 ? 0 : header.size()), chunk.size() - (written == 0 ? 0 : header.size()));
+        if (count > 0) {
+            written += count;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    close(fd);
+}
+
+void run(std::string const& name, std::string const& path, size_t pipes, size_t messages, size_t size, size_t runawayBytes) {
+    std::vector<std::unique_ptr<UnixPipe>> writers;
+    std::vector<std::unique_ptr<UnixPipe>> readers;
+    bench::LatencyRecorder latencies(messages);
+    std::atomic<size_t> received(0);
+    for (size_t idx = 0; idx < pipes; ++idx) {
+        std::string pipePath = path + "-" + std::to_string(idx);
+        writers.emplace_back(new UnixPipe(pipePath, PipeAccess::Write, bench::fifoConfig()));
+        readers.emplace_back(new UnixPipe(pipePath, PipeAccess::Read, bench::fifoConfig()));
+        readers.back()->addViewCallback("data", [&](std::string_view msg) {
+            latencies.record(bench::nowNs() - bench::payloadTimestamp(msg.data()));
+            received.fetch_add(1, std::memory_order_release);
+        });
+        readers.back()->start();
+    }
+    std::string bulkPath = path + "-bulk";
+    UnixPipe bulk(bulkPath, PipeAccess::Read, bench::fifoConfig());
+    bulk.addViewCallback("bulk", [](std::string_view) {});
+    bulk.start();
+
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> peak(0);
+    std::thread sampler([&]() {
+        while (!stop.load(std::memory_order_acquire)) {
+            peak.store(std::max(peak.load(std::memory_order_relaxed), MemoryGovernor::instance().used()), std::memory_order_relaxed);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::thread bulkWriter(runaway, std::cref(bulkPath), runawayBytes, std::cref(stop));
+
+    uint64_t pressure = MemoryGovernor::instance().pressureEvents();
+    uint64_t pauses = MemoryGovernor::instance().pauses();
+    uint64_t drops = MemoryGovernor::instance().drops();
+    uint64_t wallStart = bench::nowNs();
+    for (size_t idx = 0; idx < messages; ++idx) {
+        writers[idx % pipes]->write("data", bench::makePayload(bench::nowNs(), size));
+    }
+    for (auto& writer : writers) {
+        writer->flush();
+    }
+    while (received.load(std::memory_order_acquire) < messages) {
+        std::this_thread::yield();
+    }
+    uint64_t wallNs = bench::nowNs() - wallStart;
+    stop.store(true, std::memory_order_release);
+    bulkWriter.join();
+    sampler.join();
+
+    std::printf("%-12s %10.1f %10lu %8lu %8lu %12.0f %10.2f\n", name.c_str(), peak.load() / 1e6,
+        static_cast<unsigned long>(MemoryGovernor::instance().pressureEvents() - pressure),
+        static_cast<unsigned long>(MemoryGovernor::instance().pauses() - pauses),
+        static_cast<unsigned long>(MemoryGovernor::instance().drops() - drops),
+        messages / (wallNs / 1e9), latencies.percentile(99) / 1e3);
+    std::fflush(stdout);
+    for (size_t idx = 0; idx < pipes; ++idx) {
+        unlink((path + "-" + std::to_string(idx)).c_str());
+    }
+    unlink(bulkPath.c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t pipes = bench::option(argc, argv, "--pipes", 4);
+    size_t messages = bench::option(argc, argv, "--messages", 200000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t runawayBytes = bench::option(argc, argv, "--runaway", 256 * 1024 * 1024);
+    size_t budget = bench::option(argc, argv, "--budget", 16 * 1024 * 1024);
+    std::string path = "/tmp/pipe-cxx-bench-governor-" + std::to_string(getpid());
+
+    std::printf("%-12s %10s %10s %8s %8s %12s %10s\n", "variant", "peak[MB]", "pressure", "pauses", "drops", "msg/s", "p99[us]");
+    MemoryGovernor::instance().configure(0);
+    run("unlimited", path, pipes, messages, size, runawayBytes);
+    MemoryGovernor::instance().configure(budget, MemoryAction::Pause);
+    run("pause", path, pipes, messages, size, runawayBytes);
+    MemoryGovernor::instance().configure(budget, MemoryAction::Drop);
+    run("drop", path, pipes, messages, size, runawayBytes);
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "Benchmark.hxx"
+#include "PipeReactor.hxx"
+
+#include <malloc.h>
+
+/*
+ * Registers many reader pipes and reports the resident memory per pipe while
+ * they are idle, after each received one message and after the reactor let them
+ * hibernate, with and without the buffers pooled by the process. Thread per pipe readers are measured for comparison. Finally one
+ * message is sent to hibernated pipes to measure the latency of waking them up.
+ *
+ * Usage: pipe-cxx-bench-hibernate [--pipes N] [--threads N] [--size BYTES] [--idle-ms MS] [--samples N]
+ */
+
+namespace {
+
+/*
+ * \brief Resident memory after returning freed heap memory to the system
+ */
+size_t trimmedResident() {
+    malloc_trim(0);
+    return bench::residentBytes();
+}
+
+void printRow(std::string const& name, size_t pipes, size_t before, size_t after) {
+    std::printf("%-28s %8lu %14.0f\n", name.c_str(), static_cast<unsigned long>(pipes),
+        after > before ? static_cast<double>(after - before) / pipes : 0.0);
+    std::fflush(stdout);
+}
+
+void waitFor(std::atomic<size_t> const& received, size_t messages) {
+    while (received.load(std::memory_order_acquire) < messages) {
+        std::this_thread::yield();
+    }
+}
+
+/*
+ * \brief Send one message through a writer opened only for this message
+ */
+void sendOne(std::string const& path, std::string const& payload) {
+    UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+    writer.write("data", payload);
+}
+
+void benchReactor(std::string const& path, size_t count, size_t size, size_t idleMs, size_t samples) {
+    PipeConfig config = bench::fifoConfig();
+    config.hibernateAfterMs = idleMs;
+    std::atomic<size_t> received(0);
+    bench::LatencyRecorder latency(samples);
+    std::atomic<bool> measure(false);
+    size_t base = trimmedResident();
+    {
+        PipeReactor reactor;
+        std::vector<std::unique_ptr<UnixPipe>> pipes;
+        for (size_t idx = 0; idx < count; ++idx) {
+            pipes.emplace_back(new UnixPipe(path + std::to_string(idx), PipeAccess::Read, config));
+            pipes.back()->addViewCallback("data", [&received, &latency, &measure](std::string_view msg) {
+                if (measure.load(std::memory_order_relaxed)) {
+                    latency.record(bench::nowNs() - bench::payloadTimestamp(msg.data()));
+                }
+                received.fetch_add(1, std::memory_order_release);
+            });
+            reactor.add(*pipes.back());
+        }
+        reactor.start();
+        printRow("reactor registered", count, base, trimmedResident());
+
+        for (size_t idx = 0; idx < count; ++idx) {
+            sendOne(path + std::to_string(idx), bench::makePayload(0, size));
+        }
+        waitFor(received, count);
+        printRow("reactor after one message", count, base, trimmedResident());
+
+        while (reactor.hibernating() < count) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        printRow("reactor hibernated", count, base, trimmedResident());
+        // The pool keeps up to BufferPool::MAX_POOLED released buffers for the whole process
+        BufferPool::instance().trim();
+        printRow("reactor hibernated, no pool", count, base, trimmedResident());
+
+        // Every sample wakes up a different hibernated pipe
+        measure = true;
+        samples = std::min(samples, count);
+        for (size_t idx = 0; idx < samples; ++idx) {
+            UnixPipe writer(path + std::to_string(idx), PipeAccess::Write, bench::fifoConfig());
+            writer.write("data", bench::makePayload(bench::nowNs(), size));
+            waitFor(received, count + idx + 1);
+        }
+        std::printf("wake up latency p50 %lu ns, p99 %lu ns, p99.9 %lu ns\n", static_cast<unsigned long>(latency.percentile(50)),
+            static_cast<unsigned long>(latency.percentile(99)), static_cast<unsigned long>(latency.percentile(99.9)));
+    }
+    for (size_t idx = 0; idx < count; ++idx) {
+        unlink((path + std::to_string(idx)).c_str());
+    }
+}
+
+void benchThreads(std::string const& path, size_t count, size_t size) {
+    std::atomic<size_t> received(0);
+    size_t base = trimmedResident();
+    {
+        std::vector<std::unique_ptr<UnixPipe>> pipes;
+        for (size_t idx = 0; idx < count; ++idx) {
+            pipes.emplace_back(new UnixPipe(path + std::to_string(idx), PipeAccess::Read, bench::fifoConfig()));
+            pipes.back()->addViewCallback("data", [&received](std::string_view) {
+                received.fetch_add(1, std::memory_order_release);
+            });
+            pipes.back()->start();
+        }
+        for (size_t idx = 0; idx < count; ++idx) {
+            sendOne(path + std::to_string(idx), bench::makePayload(0, size));
+        }
+        waitFor(received, count);
+        printRow("thread per pipe", count, base, trimmedResident());
+    }
+    for (size_t idx = 0; idx < count; ++idx) {
+        unlink((path + std::to_string(idx)).c_str());
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t pipes = bench::option(argc, argv, "--pipes", 5000);
+    size_t threads = bench::option(argc, argv, "--threads", 100);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t idleMs = bench::option(argc, argv, "--idle-ms", 200);
+    size_t samples = bench::option(argc, argv, "--samples", 1000);
+    std::string path = "/tmp/pipe-cxx-bench-hibernate-" + std::to_string(getpid()) + "-";
+
+    std::printf("%-28s %8s %14s\n", "variant", "pipes", "rss[B/pipe]");
+    benchThreads(path, threads, size);
+    benchReactor(path, pipes, size, idleMs, samples);
+    return 0;
+}
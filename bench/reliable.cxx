@@ -0,0 +1,205 @@
+#include "Benchmark.hxx"
+#include "ReliablePipe.hxx"
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/*
+ * Compares the throughput of UnixPipe against ReliableWriter/ReliableReader for
+ * different acknowledgement batch sizes. The final runs restart the reader in the
+ * middle of the stream, once gracefully and once by killing its process while
+ * messages are in flight, and check that every message is processed exactly once.
+ *
+ * Usage: pipe-cxx-bench-reliable [--messages N] [--size BYTES]
+ */
+
+namespace {
+
+/*
+ * \brief Remove the pipes and files of a reliable pipe
+ */
+void cleanup(std::string const& path) {
+    for (char const* suffix : { "", ReliableProtocol::CONTROL_SUFFIX, ReliableProtocol::JOURNAL_SUFFIX, ReliableProtocol::STATE_SUFFIX }) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+void printRow(std::string const& name, size_t messages, uint64_t wallNs, uint64_t cpuNs, uint64_t duplicates) {
+    std::printf("%-24s %12.0f %14.1f %12lu\n", name.c_str(), messages / (wallNs / 1e9), static_cast<double>(cpuNs) / messages,
+        static_cast<unsigned long>(duplicates));
+    std::fflush(stdout);
+}
+
+void waitFor(std::atomic<size_t> const& received, size_t messages) {
+    while (received.load(std::memory_order_acquire) < messages) {
+        std::this_thread::yield();
+    }
+}
+
+void runUnreliable(std::string const& path, size_t messages, std::string const& payload) {
+    std::atomic<size_t> received(0);
+    {
+        UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+        UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+        reader.addCallback("data", [&received](std::string const&) {
+            received.fetch_add(1, std::memory_order_release);
+        });
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write("data", payload);
+        }
+        waitFor(received, messages);
+        printRow("unreliable", messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart, 0);
+    }
+    cleanup(path);
+}
+
+void runReliable(std::string const& path, size_t messages, std::string const& payload, size_t ackBatch) {
+    std::atomic<size_t> received(0);
+    {
+        ReliableWriter writer(path, ReliableWriter::DEFAULT_JOURNAL_SIZE, bench::fifoConfig());
+        ReliableReader reader(path, ackBatch, bench::fifoConfig());
+        reader.addCallback("data", [&received](std::string const&) {
+            received.fetch_add(1, std::memory_order_release);
+        });
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write("data", payload);
+        }
+        waitFor(received, messages);
+        printRow("reliable ack " + std::to_string(ackBatch), messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart, reader.duplicates());
+    }
+    cleanup(path);
+}
+
+/*
+ * \brief Restart the reader after half of the messages, every message has to be processed exactly once
+ * \return True if no message was lost or processed twice
+ */
+bool runRestart(std::string const& path, size_t messages, std::string const& payload) {
+    std::vector<uint8_t> seen(messages, 0);
+    std::atomic<size_t> received(0);
+    auto callback = [&seen, &received](std::string const& msg) {
+        ++seen[std::stoul(msg)];
+        received.fetch_add(1, std::memory_order_release);
+    };
+    uint64_t duplicates = 0;
+    uint64_t cpuStart = bench::cpuNs();
+    uint64_t wallStart = bench::nowNs();
+    {
+        ReliableWriter writer(path, ReliableWriter::DEFAULT_JOURNAL_SIZE, bench::fifoConfig());
+        std::unique_ptr<ReliableReader> reader(new ReliableReader(path, ReliableReader::DEFAULT_ACK_BATCH, bench::fifoConfig()));
+        reader->addCallback("data", callback);
+        reader->start();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write("data", std::to_string(idx) + ";" + payload);
+            if (idx == messages / 2) {
+                // Frames still in the pipe are resent to the new reader and then arrive twice
+                duplicates += reader->duplicates();
+                reader.reset(new ReliableReader(path, ReliableReader::DEFAULT_ACK_BATCH, bench::fifoConfig()));
+                reader->addCallback("data", callback);
+                reader->start();
+            }
+        }
+        writer.flush();
+        waitFor(received, messages);
+        duplicates += reader->duplicates();
+    }
+    printRow("reliable restart", messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart, duplicates);
+    cleanup(path);
+    return std::all_of(seen.begin(), seen.end(), [](uint8_t count) { return count == 1; }) && received.load() == messages;
+}
+
+/*
+ * \brief Kill the reader process in the middle of the stream, messages it had read but not processed reach its successor
+ * \return True if every message was processed once, except the one whose callback ran when the reader was killed before its progress was persisted
+ */
+bool runCrash(std::string const& path, size_t messages, std::string const& payload) {
+    // Processing counts per message, shared with the reader process
+    uint8_t* seen = static_cast<uint8_t*>(mmap(nullptr, messages, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (seen == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    // Forked before the writer starts its threads
+    pid_t child = fork();
+    if (child == 0) {
+        ReliableReader reader(path, ReliableReader::DEFAULT_ACK_BATCH, bench::fifoConfig());
+        // Slower than the writer, so it is killed in the middle of a batch of received frames
+        reader.addCallback("data", [seen](std::string const& msg) {
+            uint64_t until = bench::nowNs() + 2000;
+            while (bench::nowNs() < until) {}
+            ++seen[std::stoul(msg)];
+        });
+        reader.start();
+        while (true) {
+            pause();
+        }
+    }
+    uint64_t duplicates = 0;
+    uint64_t interrupted = 0;
+    uint64_t cpuStart = bench::cpuNs();
+    uint64_t wallStart = bench::nowNs();
+    {
+        ReliableWriter writer(path, ReliableWriter::DEFAULT_JOURNAL_SIZE, bench::fifoConfig());
+        std::unique_ptr<ReliableReader> reader;
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write("data", std::to_string(idx) + ";" + payload);
+            if (idx == messages / 2) {
+                writer.flush();
+                kill(child, SIGKILL);
+                waitpid(child, nullptr, 0);
+                // The message after the persisted progress may have been processed without persisting it
+                std::ifstream state(path + ReliableProtocol::STATE_SUFFIX, std::ios::binary);
+                state.read(reinterpret_cast<char*>(&interrupted), sizeof(interrupted));
+                reader.reset(new ReliableReader(path, ReliableReader::DEFAULT_ACK_BATCH, bench::fifoConfig()));
+                reader->addCallback("data", [seen](std::string const& msg) {
+                    ++seen[std::stoul(msg)];
+                });
+                reader->start();
+            }
+        }
+        writer.flush();
+        while (reader->processed() < messages) {
+            std::this_thread::yield();
+        }
+        duplicates = reader->duplicates();
+    }
+    printRow("reliable crash", messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart, duplicates);
+    cleanup(path);
+    bool exact = true;
+    for (size_t idx = 0; idx < messages; ++idx) {
+        exact = exact && (seen[idx] == 1 || (seen[idx] == 2 && idx == interrupted));
+    }
+    munmap(seen, messages);
+    return exact;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 500000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    std::string path = "/tmp/pipe-cxx-bench-reliable-" + std::to_string(getpid());
+    std::string payload(size, 'x');
+
+    std::printf("%-24s %12s %14s %12s\n", "variant", "msg/s", "cpu[ns/msg]", "duplicates");
+    runUnreliable(path, messages, payload);
+    for (size_t ackBatch : { 1, 16, 256 }) {
+        runReliable(path, messages, payload, ackBatch);
+    }
+    if (!runRestart(path, messages, payload)) {
+        std::printf("Restart lost or duplicated messages.\n");
+        return 1;
+    }
+    if (!runCrash(path, messages, payload)) {
+        std::printf("Crash lost or duplicated messages.\n");
+        return 1;
+    }
+    return 0;
+}
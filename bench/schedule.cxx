@@ -0,0 +1,92 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+#include <random>
+
+/*
+ * Schedules messages with random delays, once with a sleeping thread per message
+ * and once with UnixPipe::writeAt. Reports the CPU time per message and how late
+ * the messages arrived at the reader compared to their due time.
+ *
+ * Usage: pipe-cxx-bench-schedule [--messages N] [--size BYTES] [--spread-ms MS]
+ */
+
+namespace {
+
+void printRow(std::string const& name, size_t messages, uint64_t cpuNs, bench::LatencyRecorder& lateness) {
+    std::printf("%-20s %10lu %12.0f %12.1f %12.1f %12.1f\n", name.c_str(), static_cast<unsigned long>(messages),
+        static_cast<double>(cpuNs) / messages, lateness.percentile(50) / 1e3, lateness.percentile(99) / 1e3,
+        lateness.percentile(99.9) / 1e3);
+    std::fflush(stdout);
+}
+
+/*
+ * \brief Run a reader recording the lateness of each message and schedule all messages
+ * \param schedule Callable taking the writer, the due time and the payload
+ * \param finish Callable called after all messages were received, before the writer is closed
+ */
+template<typename Schedule, typename Finish>
+void run(std::string const& name, size_t messages, size_t size, std::vector<uint64_t> const& delays, Schedule schedule, Finish finish) {
+    std::string path = "/tmp/pipe-cxx-bench-schedule-" + std::to_string(getpid());
+    bench::LatencyRecorder lateness(messages);
+    std::atomic<size_t> received(0);
+    {
+        UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+        UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+        reader.addViewCallback("data", [&lateness, &received](std::string_view msg) {
+            lateness.record(bench::nowNs() - bench::payloadTimestamp(msg.data()));
+            received.fetch_add(1, std::memory_order_release);
+        });
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t start = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            uint64_t due = start + delays[idx];
+            schedule(writer, due, bench::makePayload(due, size));
+        }
+        while (received.load(std::memory_order_acquire) < messages) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        finish();
+        printRow(name, messages, bench::cpuNs() - cpuStart, lateness);
+    }
+    unlink(path.c_str());
+}
+
+/*
+ * \brief Convert a bench::nowNs() timestamp to a steady clock time point
+ */
+std::chrono::steady_clock::time_point toTimePoint(uint64_t ns) {
+    return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 2000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t spreadMs = bench::option(argc, argv, "--spread-ms", 1000);
+
+    std::mt19937_64 random(42);
+    std::vector<uint64_t> delays(messages);
+    for (uint64_t& delay : delays) {
+        delay = random() % (spreadMs * 1000000 + 1);
+    }
+
+    std::printf("%-20s %10s %12s %12s %12s %12s\n", "variant", "messages", "cpu[ns/msg]", "late p50[us]", "late p99[us]", "p99.9[us]");
+    std::vector<std::thread> threads;
+    run("thread per message", messages, size, delays, [&threads](UnixPipe& writer, uint64_t due, std::string payload) {
+        threads.emplace_back([&writer, due, payload]() {
+            std::this_thread::sleep_until(toTimePoint(due));
+            writer.write("data", payload);
+        });
+    }, [&threads]() {
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+    run("timer wheel", messages, size, delays, [](UnixPipe& writer, uint64_t due, std::string payload) {
+        writer.writeAt(toTimePoint(due), "data", std::move(payload));
+    }, []() {});
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "Benchmark.hxx"
+#include "Quote.hxx"
+
+/*
+ * Compares handwritten text serialization into owned objects against the
+ * encoders and in-place views generated by pipe-cxx-schemac from Quote.schema,
+ * once for the codec alone and once end to end through UnixPipe.
+ *
+ * Usage: pipe-cxx-bench-schema [--messages N] [--levels N]
+ */
+
+namespace {
+
+// Prevents the compiler from removing the benchmarked work
+double g_sink = 0;
+
+market::Quote makeQuote(size_t levels) {
+    market::Quote quote;
+    quote.symbol = "ACME.XNAS";
+    quote.sequence = 42;
+    for (size_t idx = 0; idx < levels; ++idx) {
+        quote.bids.push_back({ 100.0 - idx * 0.01, static_cast<uint32_t>(100 + idx) });
+        quote.asks.push_back({ 100.01 + idx * 0.01, static_cast<uint32_t>(200 + idx) });
+    }
+    quote.venues = { "XNAS", "ARCX", "BATS" };
+    return quote;
+}
+
+/*
+ * \brief Handwritten serialization as it is typically done on top of write(id, std::string)
+ */
+std::string toText(market::Quote const& quote) {
+    std::string text = quote.symbol + "|" + std::to_string(quote.sequence) + "|";
+    for (auto const* side : { &quote.bids, &quote.asks }) {
+        text += std::to_string(side->size()) + "|";
+        for (market::Level const& level : *side) {
+            text += std::to_string(level.price) + "," + std::to_string(level.quantity) + ";";
+        }
+        text += "|";
+    }
+    for (std::string const& venue : quote.venues) {
+        text += venue + ",";
+    }
+    return text;
+}
+
+/*
+ * \brief Handwritten parsing into an owned object
+ */
+market::Quote fromText(std::string const& text) {
+    market::Quote quote;
+    size_t pos = text.find('|');
+    quote.symbol = text.substr(0, pos);
+    quote.sequence = std::stoull(text.substr(pos + 1));
+    pos = text.find('|', pos + 1);
+    for (auto* side : { &quote.bids, &quote.asks }) {
+        size_t count = std::stoul(text.substr(pos + 1));
+        pos = text.find('|', pos + 1);
+        for (size_t idx = 0; idx < count; ++idx) {
+            size_t comma = text.find(',', pos + 1);
+            size_t semicolon = text.find(';', comma);
+            side->push_back({ std::stod(text.substr(pos + 1, comma - pos - 1)), static_cast<uint32_t>(std::stoul(text.substr(comma + 1, semicolon - comma - 1))) });
+            pos = semicolon;
+        }
+        pos = text.find('|', pos + 1);
+    }
+    for (size_t end = text.find(',', pos + 1); end != std::string::npos; pos = end, end = text.find(',', pos + 1)) {
+        quote.venues.push_back(text.substr(pos + 1, end - pos - 1));
+    }
+    return quote;
+}
+
+/*
+ * \brief Consume all fields of an owned quote
+ */
+void consume(market::Quote const& quote) {
+    g_sink += quote.symbol.size() + quote.sequence + quote.venues.size();
+    for (market::Level const& level : quote.bids) {
+        g_sink += level.price * level.quantity;
+    }
+    for (market::Level const& level : quote.asks) {
+        g_sink += level.price * level.quantity;
+    }
+}
+
+/*
+ * \brief Consume all fields of a quote view
+ */
+void consume(market::QuoteView const& quote) {
+    g_sink += quote.symbol().size() + quote.sequence() + quote.venues().size();
+    for (market::LevelView level : quote.bids()) {
+        g_sink += level.price() * level.quantity();
+    }
+    for (market::LevelView level : quote.asks()) {
+        g_sink += level.price() * level.quantity();
+    }
+}
+
+void printRow(std::string const& name, size_t messages, uint64_t wallNs, uint64_t cpuNs) {
+    std::printf("%-32s %12.0f %14.1f\n", name.c_str(), messages / (wallNs / 1e9), static_cast<double>(cpuNs) / messages);
+    std::fflush(stdout);
+}
+
+/*
+ * \brief Run count messages through a writer/reader pair and print the result
+ */
+template<typename Setup, typename Send>
+void runPipe(std::string const& name, size_t messages, Setup setup, Send send) {
+    std::string path = "/tmp/pipe-cxx-bench-schema-" + std::to_string(getpid());
+    std::atomic<size_t> received(0);
+    {
+        UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+        UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+        setup(reader, received);
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            send(writer);
+        }
+        while (received.load(std::memory_order_acquire) < messages) {
+            std::this_thread::yield();
+        }
+        printRow(name, messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart);
+    }
+    unlink(path.c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 200000);
+    size_t levels = bench::option(argc, argv, "--levels", 5);
+    market::Quote quote = makeQuote(levels);
+
+    std::printf("%-32s %12s %14s\n", "variant", "msg/s", "cpu[ns/msg]");
+    // Codec only
+    {
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            consume(fromText(toText(quote)));
+        }
+        printRow("codec handwritten", messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart);
+    }
+    {
+        std::string buffer;
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            buffer.resize(schema::Traits<market::Quote>::encodedSize(quote));
+            schema::Traits<market::Quote>::encode(quote, &buffer[0]);
+            if (schema::Traits<market::Quote>::validate(buffer.data(), buffer.size()) == buffer.size()) {
+                consume(market::QuoteView(buffer.data()));
+            }
+        }
+        printRow("codec generated", messages, bench::nowNs() - wallStart, bench::cpuNs() - cpuStart);
+    }
+    // End to end through the named pipe
+    runPipe("pipe handwritten", messages, [](UnixPipe& reader, std::atomic<size_t>& received) {
+        reader.addCallback(market::Quote::ID, [&received](std::string const& msg) {
+            consume(fromText(msg));
+            received.fetch_add(1, std::memory_order_release);
+        });
+    }, [&](UnixPipe& writer) {
+        writer.write(market::Quote::ID, toText(quote));
+    });
+    runPipe("pipe generated", messages, [](UnixPipe& reader, std::atomic<size_t>& received) {
+        schema::subscribe<market::Quote>(reader, [&received](market::QuoteView const& view) {
+            consume(view);
+            received.fetch_add(1, std::memory_order_release);
+        });
+    }, [&](UnixPipe& writer) {
+        schema::write(writer, quote);
+    });
+    return g_sink == 0;
+}
@@ -0,0 +1,73 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * Sends notifications without payload through the named pipe, once as empty
+ * messages and once as signals coalesced in the shared signal counters.
+ * Reports notifications per second until the reader saw all of them, the CPU
+ * time of the process per notification and the number of callback calls.
+ *
+ * Usage: pipe-cxx-bench-signal [--notifications N] [--writers N]
+ */
+
+namespace {
+
+void run(std::string const& name, bool signals, size_t notifications, size_t writers) {
+    std::string path = "/tmp/pipe-cxx-bench-signal-" + std::to_string(getpid());
+    std::atomic<uint64_t> received(0);
+    std::atomic<uint64_t> calls(0);
+    {
+        UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+        if (signals) {
+            reader.addSignalCallback("invalidate", [&](uint64_t count) {
+                received.fetch_add(count, std::memory_order_release);
+                calls.fetch_add(1, std::memory_order_relaxed);
+            });
+        } else {
+            reader.addViewCallback("invalidate", [&](std::string_view) {
+                received.fetch_add(1, std::memory_order_release);
+                calls.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        reader.start();
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        std::vector<std::thread> threads;
+        for (size_t idx = 0; idx < writers; ++idx) {
+            threads.emplace_back([&]() {
+                UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+                for (size_t count = 0; count < notifications; ++count) {
+                    if (signals) {
+                        writer.signal("invalidate");
+                    } else {
+                        writer.write("invalidate", "");
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        while (received.load(std::memory_order_acquire) < notifications * writers) {
+            std::this_thread::yield();
+        }
+        double seconds = (bench::nowNs() - wallStart) / 1e9;
+        std::printf("%-12s %8zu %14.0f %14.1f %12lu\n", name.c_str(), writers, notifications * writers / seconds,
+            static_cast<double>(bench::cpuNs() - cpuStart) / (notifications * writers), static_cast<unsigned long>(calls.load()));
+        std::fflush(stdout);
+    }
+    unlink(path.c_str());
+    unlink((path + UnixPipe::SIGNAL_SUFFIX).c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t notifications = bench::option(argc, argv, "--notifications", 200000);
+    size_t writers = bench::option(argc, argv, "--writers", 1);
+
+    std::printf("%-12s %8s %14s %14s %12s\n", "variant", "writers", "notify/s", "cpu[ns]", "callbacks");
+    run("messages", false, notifications, writers);
+    run("signals", true, notifications, writers);
+    return 0;
+}
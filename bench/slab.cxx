@@ -0,0 +1,163 @@
+#include "Benchmark.hxx"
+#include "SlabAllocator.hxx"
+#include "UnixPipe.hxx"
+
+#include <new>
+
+/*
+ * Counts calls of the global allocator while messages are decoded and
+ * dispatched in steady state, once through the in-process channel whose
+ * messages live in slab blocks and once through the named pipe, each with view
+ * callbacks and with copying callbacks. A second part compares allocating and
+ * releasing blocks of random size from one thread and releasing them on
+ * another thread against new and delete.
+ *
+ * Usage: pipe-cxx-bench-slab [--messages N] [--size BYTES] [--blocks N]
+ */
+
+namespace {
+
+// Number of calls of the global operator new
+std::atomic<size_t> g_allocations(0);
+
+void dispatch(std::string const& name, PipeConfig const& config, bool view, size_t messages, size_t size) {
+    std::string path = "/tmp/pipe-cxx-bench-slab-" + std::to_string(getpid());
+    std::atomic<size_t> received(0);
+    {
+        UnixPipe writer(path, PipeAccess::Write, config);
+        UnixPipe reader(path, PipeAccess::Read, config);
+        if (view) {
+            reader.addViewCallback("data", [&received](std::string_view) {
+                received.fetch_add(1, std::memory_order_release);
+            });
+        } else {
+            reader.addCallback("data", [&received](std::string const&) {
+                received.fetch_add(1, std::memory_order_release);
+            });
+        }
+        reader.start();
+        auto encode = [size](char* data) {
+            std::memset(data, 'x', size);
+        };
+        // Warm up slabs, buffers and the reused decode storage
+        for (size_t idx = 0; idx < 1000; ++idx) {
+            writer.writeWith("data", size, encode);
+        }
+        while (received.load(std::memory_order_acquire) < 1000) {
+            std::this_thread::yield();
+        }
+        size_t allocations = g_allocations.load(std::memory_order_relaxed);
+        uint64_t start = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.writeWith("data", size, encode);
+        }
+        writer.flush();
+        while (received.load(std::memory_order_acquire) < messages + 1000) {
+            std::this_thread::yield();
+        }
+        double seconds = (bench::nowNs() - start) / 1e9;
+        std::printf("%-24s %12.0f %16.4f\n", name.c_str(), messages / seconds,
+            static_cast<double>(g_allocations.load(std::memory_order_relaxed) - allocations) / messages);
+        std::fflush(stdout);
+    }
+    unlink(path.c_str());
+}
+
+/*
+ * \brief Allocate blocks on this thread and release them on another one, like queued messages
+ */
+template<typename Allocate, typename Release>
+void allocator(std::string const& name, size_t blocks, Allocate&& allocate, Release&& release) {
+    std::vector<size_t> sizes(blocks);
+    for (size_t idx = 0; idx < blocks; ++idx) {
+        sizes[idx] = 16 + (idx * 2654435761u) % 1024;
+    }
+    // Handed over in batches through a mutex, the same for both variants
+    std::mutex mutex;
+    std::vector<void*> handed;
+    std::atomic<bool> done(false);
+    std::thread releaser([&]() {
+        std::vector<void*> batch;
+        while (true) {
+            bool last = done.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch.swap(handed);
+            }
+            for (void* ptr : batch) {
+                release(ptr);
+            }
+            batch.clear();
+            if (last) {
+                break;
+            }
+        }
+    });
+    uint64_t start = bench::nowNs();
+    std::vector<void*> batch;
+    for (size_t idx = 0; idx < blocks; ++idx) {
+        void* ptr = allocate(sizes[idx]);
+        static_cast<char*>(ptr)[0] = 'x';
+        batch.push_back(ptr);
+        if (batch.size() == 64) {
+            std::lock_guard<std::mutex> lock(mutex);
+            handed.insert(handed.end(), batch.begin(), batch.end());
+            batch.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        handed.insert(handed.end(), batch.begin(), batch.end());
+    }
+    done.store(true, std::memory_order_release);
+    releaser.join();
+    std::printf("%-24s %12.1f\n", name.c_str(), static_cast<double>(bench::nowNs() - start) / blocks);
+    std::fflush(stdout);
+}
+
+}
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 500000);
+    size_t size = bench::option(argc, argv, "--size", 256);
+    size_t blocks = bench::option(argc, argv, "--blocks", 5000000);
+
+    PipeConfig local = PipeConfig::fromEnvironment();
+    local.localShortcut = true;
+
+    std::printf("%-24s %12s %16s\n", "dispatch", "msg/s", "allocations/msg");
+    dispatch("local view", local, true, messages, size);
+    dispatch("local copy", local, false, messages, size);
+    dispatch("fifo view", bench::fifoConfig(), true, messages, size);
+    dispatch("fifo copy", bench::fifoConfig(), false, messages, size);
+
+    std::printf("\n%-24s %12s\n", "allocator", "ns/block");
+    allocator("new/delete", blocks, [](size_t bytes) {
+        return ::operator new(bytes);
+    }, [](void* ptr) {
+        ::operator delete(ptr);
+    });
+    SlabAllocator slab;
+    allocator("slab", blocks, [&slab](size_t bytes) {
+        return slab.allocate(bytes);
+    }, [&slab](void* ptr) {
+        slab.deallocate(ptr);
+    });
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * Writes messages round robin over a number of identifiers to a reader with
+ * callbacks for only some of them, once sending everything and once with the
+ * writer filtering the identifiers advertised by the reader.
+ *
+ * Usage: pipe-cxx-bench-subscribe [--messages N] [--size BYTES] [--ids N] [--subscribed N]
+ */
+
+namespace {
+
+void run(std::string const& name, size_t messages, size_t size, size_t ids, size_t subscribed, bool filter) {
+    std::string path = "/tmp/pipe-cxx-bench-subscribe-" + std::to_string(getpid());
+    std::string payload(size, 'x');
+    std::vector<std::string> names;
+    for (size_t idx = 0; idx < ids; ++idx) {
+        names.push_back("id" + std::to_string(idx));
+    }
+    // Messages of subscribed identifiers, the last identifier is never subscribed
+    size_t expected = 0;
+    for (size_t idx = 0; idx < messages; ++idx) {
+        expected += (idx % ids) < subscribed ? 1 : 0;
+    }
+    std::atomic<size_t> received(0);
+    {
+        UnixPipe writer(path, PipeAccess::Write, bench::fifoConfig());
+        UnixPipe reader(path, PipeAccess::Read, bench::fifoConfig());
+        for (size_t idx = 0; idx < subscribed; ++idx) {
+            reader.addViewCallback(names[idx], [&received](std::string_view) {
+                received.fetch_add(1, std::memory_order_release);
+            });
+        }
+        if (filter) {
+            writer.filterSubscriptions();
+            reader.advertiseSubscriptions();
+        }
+        reader.start();
+        // Wait until the advertisement reached the writer
+        while (filter && writer.skipped() == 0) {
+            writer.write(names[ids - 1], payload);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < messages; ++idx) {
+            writer.write(names[idx % ids], payload);
+        }
+        while (received.load(std::memory_order_acquire) < expected) {
+            std::this_thread::yield();
+        }
+        uint64_t wallNs = bench::nowNs() - wallStart;
+        std::printf("%-20s %12.0f %14.1f %12lu\n", name.c_str(), messages / (wallNs / 1e9), static_cast<double>(bench::cpuNs() - cpuStart) / messages,
+            static_cast<unsigned long>(writer.skipped()));
+        std::fflush(stdout);
+    }
+    unlink(path.c_str());
+    unlink((path + UnixPipe::CONTROL_SUFFIX).c_str());
+    unlink((path + UnixPipe::CONTROL_SUFFIX + ".0").c_str());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 500000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t ids = std::max<size_t>(bench::option(argc, argv, "--ids", 100), 2);
+    size_t subscribed = std::min(bench::option(argc, argv, "--subscribed", 10), ids - 1);
+
+    std::printf("%-20s %12s %14s %12s\n", "variant", "msg/s", "cpu[ns/msg]", "skipped");
+    run("send all", messages, size, ids, subscribed, false);
+    run("filtered", messages, size, ids, subscribed, true);
+    return 0;
+}
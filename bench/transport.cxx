@@ -0,0 +1,449 @@
+#include "Benchmark.hxx"
+#include "UnixPipe.hxx"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+/*
+ * Compares the named pipe and seqpacket transports of UnixPipe against other local transports
+ * using an identical workload: a single producer sends timestamped messages of
+ * a fixed size, a single consumer thread receives them and records latency.
+ * Afterwards checks that frames of exactly one and two packets sent by two
+ * interleaved writers arrive intact through the seqpacket transport.
+ *
+ * Usage: pipe-cxx-bench-transport [--messages N] [--size BYTES] [--rate MSG_PER_SEC]
+ */
+
+namespace {
+
+/*
+ * \brief Shared state of a single benchmark run
+ */
+class Harness {
+public:
+    /*
+     * \brief Create harness for the given workload
+     * \param name Name of the benchmarked transport
+     * \param messages Number of messages to send
+     * \param size Payload size of each message
+     * \param rate Messages per second, 0 for unlimited
+     */
+    Harness(std::string const& name, size_t messages, size_t size, size_t rate)
+        : m_name(name), m_messages(messages), m_size(size), m_rate(rate), m_received(0), m_latency(messages) {}
+
+    /*
+     * \brief Called by the consumer for every received payload
+     * \param payload Pointer to the received payload
+     */
+    void onMessage(char const* payload) {
+        m_latency.record(bench::nowNs() - bench::payloadTimestamp(payload));
+        m_received.fetch_add(1, std::memory_order_release);
+    }
+
+    /*
+     * \brief Check if all messages are received
+     */
+    bool done() const {
+        return m_received.load(std::memory_order_acquire) >= m_messages;
+    }
+
+    /*
+     * \brief Run producer loop on the calling thread and wait for the consumer
+     * \param send Function transmitting a single payload
+     */
+    template<typename Send>
+    bench::Result run(Send send) {
+        uint64_t cpuStart = bench::cpuNs();
+        uint64_t wallStart = bench::nowNs();
+        for (size_t idx = 0; idx < m_messages; ++idx) {
+            if (m_rate > 0) {
+                uint64_t due = wallStart + idx * 1000000000ull / m_rate;
+                while (bench::nowNs() < due) {}
+            }
+            send(bench::makePayload(bench::nowNs(), m_size));
+        }
+        while (!done()) {
+            std::this_thread::yield();
+        }
+        bench::Result result;
+        result.wallNs = bench::nowNs() - wallStart;
+        result.cpuNs = bench::cpuNs() - cpuStart;
+        result.name = m_name;
+        result.messages = m_messages;
+        result.size = m_size;
+        result.p50 = m_latency.percentile(50);
+        result.p99 = m_latency.percentile(99);
+        result.p999 = m_latency.percentile(99.9);
+        return result;
+    }
+
+private:
+    std::string m_name;
+    size_t m_messages;
+    size_t m_size;
+    size_t m_rate;
+    std::atomic<size_t> m_received;
+    bench::LatencyRecorder m_latency;
+};
+
+/*
+ * \brief Write all bytes to a blocking file descriptor
+ */
+void writeAll(int fd, char const* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written == -1) {
+            perror("write");
+            abort();
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+/*
+ * \brief Read exactly length bytes from a blocking file descriptor
+ */
+bool readAll(int fd, char* data, size_t length) {
+    while (length > 0) {
+        ssize_t read = ::read(fd, data, length);
+        if (read <= 0) {
+            return false;
+        }
+        data += read;
+        length -= read;
+    }
+    return true;
+}
+
+/*
+ * \brief Single producer single consumer byte ring placed in shared memory
+ */
+class ShmRing {
+public:
+    // Capacity of the data area
+    static size_t const CAPACITY = 1 << 22;
+
+    ShmRing() {
+        void* mem = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            perror("mmap");
+            abort();
+        }
+        m_layout = new (mem) Layout();
+    }
+
+    ~ShmRing() {
+        munmap(m_layout, sizeof(Layout));
+    }
+
+    /*
+     * \brief Push a length prefixed record, spins while the ring is full
+     */
+    void push(char const* data, uint32_t length) {
+        uint64_t head = m_layout->head.load(std::memory_order_relaxed);
+        while (CAPACITY - (head - m_layout->tail.load(std::memory_order_acquire)) < length + sizeof(length)) {
+            std::this_thread::yield();
+        }
+        copyIn(head, reinterpret_cast<char const*>(&length), sizeof(length));
+        copyIn(head + sizeof(length), data, length);
+        m_layout->head.store(head + sizeof(length) + length, std::memory_order_release);
+    }
+
+    /*
+     * \brief Pop a record if available
+     * \param out Destination buffer, resized to the record
+     */
+    bool pop(std::string& out) {
+        uint64_t tail = m_layout->tail.load(std::memory_order_relaxed);
+        if (tail == m_layout->head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        uint32_t length;
+        copyOut(tail, reinterpret_cast<char*>(&length), sizeof(length));
+        out.resize(length);
+        copyOut(tail + sizeof(length), &out[0], length);
+        m_layout->tail.store(tail + sizeof(length) + length, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Layout {
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        alignas(64) char data[CAPACITY];
+    };
+    Layout* m_layout;
+
+    void copyIn(uint64_t pos, char const* data, size_t length) {
+        size_t offset = pos % CAPACITY;
+        size_t first = std::min(length, CAPACITY - offset);
+        std::memcpy(&m_layout->data[offset], data, first);
+        std::memcpy(&m_layout->data[0], data + first, length - first);
+    }
+
+    void copyOut(uint64_t pos, char* data, size_t length) {
+        size_t offset = pos % CAPACITY;
+        size_t first = std::min(length, CAPACITY - offset);
+        std::memcpy(data, &m_layout->data[offset], first);
+        std::memcpy(data + first, &m_layout->data[0], length - first);
+    }
+};
+
+/*
+ * \brief Named pipe or seqpacket socket transport through UnixPipe
+ * \param config Pipe configuration, with the local shortcut messages bypass the transport
+ */
+bench::Result benchFifo(Harness& harness, PipeConfig const& config) {
+    std::string name = "/tmp/pipe-cxx-bench-" + std::to_string(getpid());
+    bench::Result result;
+    {
+        UnixPipe writer(name, PipeAccess::Write, config);
+        UnixPipe reader(name, PipeAccess::Read, config);
+        reader.addCallback("bench", [&](std::string const& msg) {
+            harness.onMessage(msg.c_str());
+        });
+        reader.start();
+        result = harness.run([&](std::string const& payload) {
+            writer.write("bench", payload);
+        });
+    }
+    unlink(name.c_str());
+    return result;
+}
+
+/*
+ * \brief Check that frames of two writers filling whole packets arrive intact through the seqpacket transport
+ *
+ * The writers use the transport directly, so the check can send the first packet of a frame of
+ * one writer, a whole frame of the other writer and only then the rest of the first frame.
+ * \param frames Number of frames per writer
+ * \return True if every frame arrived once and unchanged
+ */
+bool checkSeqpacketFrames(size_t frames) {
+    std::string name = "/tmp/pipe-cxx-bench-" + std::to_string(getpid());
+    PipeConfig config = bench::fifoConfig();
+    config.transport = TransportType::SeqPacket;
+    // Frames of exactly one and two packets, the sizes where the end of a write was ambiguous
+    size_t const sizes[2] = { 4096, 8192 };
+    std::atomic<size_t> received(0);
+    std::atomic<size_t> corrupt(0);
+    {
+        UnixPipe reader(name, PipeAccess::Read, config);
+        std::string frame[2];
+        for (size_t writer = 0; writer < 2; ++writer) {
+            std::string id = "frame" + std::to_string(writer);
+            char fill = static_cast<char>('a' + writer);
+            // The header holds the content length, the second estimate has the final number of digits
+            size_t content = sizes[writer] - PipeCodec::frame(id, "").size();
+            content -= PipeCodec::frame(id, std::string(content, fill)).size() - sizes[writer];
+            frame[writer] = PipeCodec::frame(id, std::string(content, fill));
+            reader.addViewCallback(id, [&, fill](std::string_view msg) {
+                if (msg.find_first_not_of(fill) != std::string_view::npos) {
+                    corrupt.fetch_add(1, std::memory_order_relaxed);
+                }
+                received.fetch_add(1, std::memory_order_release);
+            });
+        }
+        if (frame[0].size() != sizes[0] || frame[1].size() != sizes[1]) {
+            return false;
+        }
+        reader.start();
+        SeqPacketTransport writers[2] = { { name, false, 0 }, { name, false, 0 } };
+        auto send = [&](size_t writer, size_t offset, bool whole) {
+            std::string const& data = frame[writer];
+            while (offset < data.size()) {
+                ssize_t written = writers[writer].write(&data[offset], data.size() - offset);
+                if (written == -1 && errno == EAGAIN) {
+                    writers[writer].waitWritable(100);
+                    continue;
+                }
+                offset += written;
+                if (!whole) {
+                    break;
+                }
+            }
+            return offset;
+        };
+        for (size_t idx = 0; idx < 2 * frames; ++idx) {
+            // The other writer sends a whole frame while the first one is in the middle of its frame
+            size_t first = idx % 2;
+            size_t offset = send(first, 0, false);
+            send(1 - first, 0, true);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            send(first, offset, true);
+        }
+        uint64_t deadline = bench::nowNs() + 10000000000ull;
+        while (received.load(std::memory_order_acquire) < 4 * frames && bench::nowNs() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    unlink(name.c_str());
+    return received.load() == 4 * frames && corrupt.load() == 0;
+}
+
+/*
+ * \brief Unix stream socket pair with length prefixed framing
+ */
+bench::Result benchStream(Harness& harness) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+        perror("socketpair");
+        abort();
+    }
+    std::thread consumer([&]() {
+        std::string buffer;
+        uint32_t length;
+        while (readAll(fds[1], reinterpret_cast<char*>(&length), sizeof(length))) {
+            buffer.resize(length);
+            if (!readAll(fds[1], &buffer[0], length)) {
+                break;
+            }
+            harness.onMessage(buffer.c_str());
+        }
+    });
+    bench::Result result = harness.run([&](std::string const& payload) {
+        uint32_t length = payload.size();
+        std::string frame(reinterpret_cast<char const*>(&length), sizeof(length));
+        frame += payload;
+        writeAll(fds[0], frame.data(), frame.size());
+    });
+    shutdown(fds[0], SHUT_RDWR);
+    consumer.join();
+    close(fds[0]);
+    close(fds[1]);
+    return result;
+}
+
+/*
+ * \brief Unix seqpacket socket pair, one message per packet
+ */
+bench::Result benchSeqpacket(Harness& harness, size_t size) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == -1) {
+        perror("socketpair");
+        abort();
+    }
+    std::thread consumer([&]() {
+        std::string buffer(size + 1, '\0');
+        while (true) {
+            ssize_t read = ::recv(fds[1], &buffer[0], buffer.size() - 1, 0);
+            if (read <= 0) {
+                break;
+            }
+            buffer[read] = '\0';
+            harness.onMessage(buffer.c_str());
+        }
+    });
+    bench::Result result = harness.run([&](std::string const& payload) {
+        if (::send(fds[0], payload.data(), payload.size(), 0) == -1) {
+            perror("send");
+            abort();
+        }
+    });
+    shutdown(fds[0], SHUT_RDWR);
+    consumer.join();
+    close(fds[0]);
+    close(fds[1]);
+    return result;
+}
+
+/*
+ * \brief Shared memory ring with a busy polling consumer
+ */
+bench::Result benchShm(Harness& harness) {
+    ShmRing ring;
+    std::thread consumer([&]() {
+        std::string buffer;
+        while (!harness.done()) {
+            if (ring.pop(buffer)) {
+                harness.onMessage(buffer.c_str());
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    bench::Result result = harness.run([&](std::string const& payload) {
+        ring.push(payload.data(), payload.size());
+    });
+    consumer.join();
+    return result;
+}
+
+/*
+ * \brief Shared memory ring with an eventfd signaled, blocking consumer
+ */
+bench::Result benchEventfd(Harness& harness) {
+    ShmRing ring;
+    int efd = eventfd(0, 0);
+    if (efd == -1) {
+        perror("eventfd");
+        abort();
+    }
+    std::thread consumer([&]() {
+        std::string buffer;
+        uint64_t value;
+        while (!harness.done()) {
+            while (ring.pop(buffer)) {
+                harness.onMessage(buffer.c_str());
+            }
+            if (!harness.done() && ::read(efd, &value, sizeof(value)) != sizeof(value)) {
+                break;
+            }
+        }
+    });
+    bench::Result result = harness.run([&](std::string const& payload) {
+        uint64_t one = 1;
+        ring.push(payload.data(), payload.size());
+        writeAll(efd, reinterpret_cast<char const*>(&one), sizeof(one));
+    });
+    consumer.join();
+    close(efd);
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = bench::option(argc, argv, "--messages", 200000);
+    size_t size = bench::option(argc, argv, "--size", 128);
+    size_t rate = bench::option(argc, argv, "--rate", 0);
+
+    bench::printHeader();
+    {
+        Harness harness("fifo (UnixPipe)", messages, size, rate);
+        bench::printResult(benchFifo(harness, bench::fifoConfig()));
+    }
+    {
+        Harness harness("in-process (UnixPipe)", messages, size, rate);
+        bench::printResult(benchFifo(harness, PipeConfig::fromEnvironment()));
+    }
+    {
+        Harness harness("seqpacket (UnixPipe)", messages, size, rate);
+        PipeConfig config = bench::fifoConfig();
+        config.transport = TransportType::SeqPacket;
+        bench::printResult(benchFifo(harness, config));
+    }
+    {
+        Harness harness("unix stream", messages, size, rate);
+        bench::printResult(benchStream(harness));
+    }
+    {
+        Harness harness("unix seqpacket", messages, size, rate);
+        bench::printResult(benchSeqpacket(harness, size));
+    }
+    {
+        Harness harness("shm ring", messages, size, rate);
+        bench::printResult(benchShm(harness));
+    }
+    {
+        Harness harness("shm ring + eventfd", messages, size, rate);
+        bench::printResult(benchEventfd(harness));
+    }
+    if (!checkSeqpacketFrames(1000)) {
+        std::printf("Seqpacket frames of two writers were lost or corrupted.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+# pipe_cxx_add_schema(<target> <schema>...)
+#
+# Generates <name>.hxx from each <name>.schema with pipe-cxx-schemac and makes
+# the generated headers available to the given target.
+function(pipe_cxx_add_schema TARGET)
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/generated)
+    file(MAKE_DIRECTORY ${OUTPUT_DIR})
+    foreach(SCHEMA ${ARGN})
+        get_filename_component(SCHEMA_PATH ${SCHEMA} ABSOLUTE)
+        get_filename_component(SCHEMA_NAME ${SCHEMA} NAME_WE)
+        set(OUTPUT ${OUTPUT_DIR}/${SCHEMA_NAME}.hxx)
+        # pipe-cxx-schemac leaves an unchanged header alone so its users are not rebuilt,
+        # the stamp records that the header is up to date with the schema
+        set(STAMP ${OUTPUT_DIR}/${SCHEMA_NAME}.stamp)
+        add_custom_command(
+            OUTPUT ${STAMP}
+            BYPRODUCTS ${OUTPUT}
+            COMMAND pipe-cxx-schemac ${SCHEMA_PATH} ${OUTPUT}
+            COMMAND ${CMAKE_COMMAND} -E touch ${STAMP}
+            DEPENDS pipe-cxx-schemac ${SCHEMA_PATH}
+            COMMENT "Generating ${SCHEMA_NAME}.hxx from ${SCHEMA}")
+        target_sources(${TARGET} PRIVATE ${STAMP} ${OUTPUT})
+    endforeach()
+    target_include_directories(${TARGET} PRIVATE ${OUTPUT_DIR})
+endfunction()
@@ -0,0 +1,243 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "PipeCodec.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * Fuzz harness of the frame parser. Built with -DPIPE_CXX_LIBFUZZER=ON it is a
+ * libFuzzer target, otherwise a standalone executable that runs the same checks
+ * on random token soups and then streams adversarial inputs (garbage, escaped
+ * and partial frame starts, overlong length fields, tag-dense payloads) through
+ * a reader pipe. It exits with a non-zero code if an invariant is violated, a
+ * valid frame behind the adversarial data is not delivered or the parse time
+ * per byte grows with the input size.
+ *
+ * Usage: pipe-cxx-fuzz-parser [--iterations N] [--seed N] [--size BYTES] [--max-ratio R]
+ */
+
+namespace {
+
+/*
+ * \brief Report a violated invariant and abort, so fuzzers record the input
+ */
+void check(bool condition, char const* what) {
+    if (!condition) {
+        std::fprintf(stderr, "parser invariant violated: %s\n", what);
+        std::abort();
+    }
+}
+
+/*
+ * \brief Parse a stream delivered in chunks the way a reader pipe does
+ * \param input Received bytes
+ * \param chunk Number of bytes delivered per read
+ */
+void parseStream(std::string_view input, size_t chunk) {
+    std::string buffer;
+    std::string id;
+    size_t offset = 0;
+    while (offset < input.size()) {
+        size_t length = std::min(chunk, input.size() - offset);
+        buffer.append(input.substr(offset, length));
+        offset += length;
+        size_t consumed = 0;
+        while (true) {
+            PipeCodec::Message msg = PipeCodec::next(std::string_view(buffer).substr(consumed), id);
+            if (msg.totalLength == 0) {
+                break;
+            }
+            check(msg.totalLength <= buffer.size() - consumed, "message exceeds the buffer");
+            if (msg.valid) {
+                check(msg.content.data() >= buffer.data() + consumed && msg.content.data() + msg.content.size() <= buffer.data() + consumed + msg.totalLength,
+                    "content outside the message");
+            }
+            consumed += msg.totalLength;
+        }
+        buffer.erase(0, consumed);
+    }
+}
+
+/*
+ * \brief Run all checks on one input
+ */
+void fuzzOne(uint8_t const* data, size_t size) {
+    std::string_view input(reinterpret_cast<char const*>(data), size);
+    // Chunking is taken from the input so the fuzzer explores it as well
+    parseStream(input, size > 0 ? data[0] % 32 + 1 : 1);
+    parseStream(input, input.size() + 1);
+    check(PipeCodec::unescape(PipeCodec::escape(input)) == input, "escape does not roundtrip");
+    // Framed identifier and content come out unchanged
+    std::string_view id = input.substr(0, input.size() / 4);
+    std::string_view content = input.substr(id.size());
+    std::string frame = PipeCodec::frame(id, content);
+    std::string idStorage;
+    PipeCodec::Message msg = PipeCodec::next(frame, idStorage);
+    check(msg.valid && msg.totalLength == frame.size(), "frame is not parsed completely");
+    check(msg.id == id && PipeCodec::unescape(msg.content) == content, "frame does not roundtrip");
+}
+
+}
+
+#ifdef PIPE_CXX_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const* data, size_t size) {
+    fuzzOne(data, size);
+    return 0;
+}
+
+#else
+
+namespace {
+
+/*
+ * \brief Get a numeric command line option
+ */
+double option(int argc, char* argv[], char const* name, double defaultValue) {
+    for (int idx = 1; idx + 1 < argc; ++idx) {
+        if (std::strcmp(argv[idx], name) == 0) {
+            return std::atof(argv[idx + 1]);
+        }
+    }
+    return defaultValue;
+}
+
+/*
+ * \brief Random input made of frame fragments, separators, digits, backslashes and random bytes
+ */
+std::string randomInput(std::mt19937_64& random) {
+    static char const* const tokens[] = { "NAMEDPIPE", "START", "END", "NAMEDPIPE:START:", ":END:", ":", "\\", "0", "12", "99999999999999999999999", "x" };
+    std::string input;
+    size_t count = random() % 64;
+    for (size_t idx = 0; idx < count; ++idx) {
+        size_t token = random() % (sizeof(tokens) / sizeof(tokens[0]) + 1);
+        if (token < sizeof(tokens) / sizeof(tokens[0])) {
+            input += tokens[token];
+        } else {
+            input += static_cast<char>(random());
+        }
+    }
+    // Valid frames in between let the parser get past the header
+    if (random() % 2 == 0) {
+        input.insert(random() % (input.size() + 1), PipeCodec::frame("id", input.substr(0, input.size() / 2)));
+    }
+    return input;
+}
+
+/*
+ * \brief Repeat a pattern up to the given size
+ */
+std::string repeat(std::string const& pattern, size_t size) {
+    std::string out;
+    out.reserve(size + pattern.size());
+    while (out.size() < size) {
+        out += pattern;
+    }
+    return out;
+}
+
+/*
+ * \brief Adversarial input of the given kind and size
+ */
+std::string adversarial(int kind, size_t size) {
+    switch (kind) {
+    case 0:
+        // Garbage without any frame start
+        return repeat("garbage:", size);
+    case 1:
+        // Escaped frame starts only
+        return repeat("\\NAMEDPIPE:START:", size);
+    case 2:
+        // Frame starts cut off before the separator
+        return repeat("NAMEDPIPE:STAR", size);
+    case 3:
+        // Length fields that never end
+        return repeat("NAMEDPIPE:START:" + std::string(64, '9'), size);
+    case 4:
+        // Frames with a broken trailer
+        return repeat("NAMEDPIPE:START:2:4:id:dataEND", size);
+    default:
+        // Valid frames whose payload consists of tags
+        return repeat(PipeCodec::frame("id", repeat("NAMEDPIPE\\ENDSTART", 4096)), size);
+    }
+}
+
+/*
+ * \brief Stream an input followed by a valid frame through a reader pipe
+ * \return Nanoseconds until the valid frame was delivered
+ */
+double streamThroughPipe(std::string const& input) {
+    std::string path = "/tmp/pipe-cxx-fuzz-parser-" + std::to_string(getpid());
+    PipeConfig config;
+    config.transport = TransportType::Memory;
+    config.localShortcut = false;
+    std::atomic<bool> delivered(false);
+    UnixPipe reader(path, PipeAccess::Read, config);
+    reader.addViewCallback("sentinel", [&delivered](std::string_view) {
+        delivered.store(true, std::memory_order_release);
+    });
+    reader.start();
+    // Raw bytes bypass the framing of a writer pipe
+    MemoryTransport raw(path, 0);
+    std::string data = input + PipeCodec::frame("sentinel", "");
+    auto start = std::chrono::steady_clock::now();
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t count = raw.write(&data[written], data.size() - written);
+        if (count == -1) {
+            raw.waitWritable(UnixPipe::POLL_TIMEOUT_MS);
+            continue;
+        }
+        written += count;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (!delivered.load(std::memory_order_acquire)) {
+        check(std::chrono::steady_clock::now() < deadline, "frame behind adversarial input is not delivered");
+        std::this_thread::yield();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = static_cast<size_t>(option(argc, argv, "--iterations", 100000));
+    std::mt19937_64 random(static_cast<uint64_t>(option(argc, argv, "--seed", 1)));
+    size_t size = static_cast<size_t>(option(argc, argv, "--size", 1 << 20));
+    double maxRatio = option(argc, argv, "--max-ratio", 3.0);
+
+    for (size_t idx = 0; idx < iterations; ++idx) {
+        std::string input = randomInput(random);
+        fuzzOne(reinterpret_cast<uint8_t const*>(input.data()), input.size());
+    }
+    std::printf("%zu random inputs passed\n", iterations);
+
+    // Parse time per byte has to stay constant when the input grows 8 times
+    static char const* const kinds[] = { "garbage", "escaped starts", "partial starts", "long lengths", "broken trailers", "tag payloads" };
+    bool linear = true;
+    std::printf("%-20s %14s %14s %8s\n", "input", "small[ns/B]", "large[ns/B]", "ratio");
+    for (int kind = 0; kind < 6; ++kind) {
+        double small = 1e300;
+        double large = 1e300;
+        // Best of three runs to exclude scheduling noise
+        for (int run = 0; run < 3; ++run) {
+            small = std::min(small, streamThroughPipe(adversarial(kind, size)) / size);
+            large = std::min(large, streamThroughPipe(adversarial(kind, size * 8)) / (size * 8));
+        }
+        double ratio = large / small;
+        linear = linear && ratio <= maxRatio;
+        std::printf("%-20s %14.2f %14.2f %8.2f\n", kinds[kind], small, large, ratio);
+        std::fflush(stdout);
+    }
+    return linear ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,349 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <climits>
+
+#include "MappedFile.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * \brief Single producer, multiple consumer broadcast of messages over a shared memory ring
+ *
+ * Works like the Disruptor: the writer publishes messages into fixed size slots and advances
+ * a shared cursor, every reader (of any process) follows with its own cursor and receives all
+ * messages. The writer only reuses a slot once the slowest reader has passed it. Readers join
+ * at the current cursor, sleep on a futex once their spin budget is exhausted and are woken
+ * by the writer only if any of them sleeps.
+ *
+ * The ring lives in the file given as name, place it on a memory file system (/dev/shm) to
+ * avoid writeback. One writer may be attached at a time, it serializes its own threads.
+ */
+class BroadcastRing {
+public:
+    // Default number of slots
+    static constexpr size_t const DEFAULT_SLOTS = 4096;
+    // Default size of a slot, bounds the size of identifier and message
+    static constexpr size_t const DEFAULT_SLOT_SIZE = 512;
+    // Maximum number of attached readers
+    static constexpr size_t const MAX_READERS = 32;
+    // Timeout in milliseconds after which sleeping threads check for stop requests and dead readers
+    static constexpr int const POLL_TIMEOUT_MS = 100;
+    // Identifies an initialized ring file
+    static constexpr uint64_t const MAGIC = 0x474e495242504950;
+
+    using Callback = UnixPipe::Callback;
+    using ViewCallback = UnixPipe::ViewCallback;
+
+    /*
+     * \brief Attach to the ring, the first process creates it
+     * \param name Name of the ring file (path)
+     * \param access Access type, either read or write
+     * \param slots Number of slots, has to match the existing ring
+     * \param slotSize Size of a slot in bytes, has to match the existing ring
+     * \param config Tuning parameters, the spin budget is used by readers and a gated writer
+     */
+    BroadcastRing(std::string const name, PipeAccess access, size_t slots = DEFAULT_SLOTS, size_t slotSize = DEFAULT_SLOT_SIZE,
+        PipeConfig const config = PipeConfig::fromEnvironment())
+        : m_access(access), m_config(config), m_file(name, sizeof(Header) + slots * slotSize), m_header(reinterpret_cast<Header*>(m_file.data())),
+          m_slots(slots), m_slotSize(slotSize), m_reader(nullptr), m_gating(0), m_hasToStop(false), m_thread() {
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared cursors require lock-free 64 bit atomics.");
+        // The file is zero filled when created, the first process initializes it
+        uint64_t magic = 0;
+        if (m_header->magic.compare_exchange_strong(magic, 1)) {
+            m_header->slots = slots;
+            m_header->slotSize = slotSize;
+            m_header->magic.store(MAGIC, std::memory_order_release);
+        }
+        while (m_header->magic.load(std::memory_order_acquire) != MAGIC) {
+            std::this_thread::yield();
+        }
+        if (m_header->slots != slots || m_header->slotSize != slotSize) {
+            throw std::logic_error("Ring exists with a different number or size of slots.");
+        }
+        if (m_access == PipeAccess::Read) {
+            attach();
+        } else {
+            m_gating = m_header->cursor.load(std::memory_order_acquire);
+        }
+    }
+
+    /*
+     * \brief Detach from the ring, stopping the reader thread if active
+     */
+    ~BroadcastRing() {
+        if (m_thread.joinable()) {
+            m_hasToStop = true;
+            m_thread.join();
+        }
+        if (m_reader) {
+            m_reader->pid.store(0, std::memory_order_release);
+        }
+    }
+
+    /*
+     * \brief Start reader thread for incoming messages
+     */
+    void start() {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to call start on ring with write access only.");
+        }
+        // Start read thread if missing
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&BroadcastRing::handleRead, this);
+        }
+    }
+
+    /*
+     * \brief Add callback for a given message identifier
+     * \param id Message identifier to use for the callback
+     * \param callback Callback to call for the message identifier
+     */
+    void addCallback(std::string const id, Callback callback) {
+        checkCallback(id);
+        m_callbacks.emplace(id, std::move(callback));
+    }
+
+    /*
+     * \brief Add callback receiving the message in place in the ring slot
+     * \param id Message identifier to use for the callback
+     * \param callback Callback to call for the message identifier, the view is only valid during the call
+     */
+    void addViewCallback(std::string const id, ViewCallback callback) {
+        checkCallback(id);
+        m_viewCallbacks.emplace(id, std::move(callback));
+    }
+
+    /*
+     * \brief Publish the message associated with given identifier to all readers, waits if the slowest reader is a full ring behind
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     */
+    void write(std::string_view id, std::string_view msg) {
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call write on ring with read access only.");
+        }
+        if (sizeof(Entry) + id.size() + msg.size() > m_slotSize) {
+            throw std::logic_error("Message does not fit into a ring slot.");
+        }
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        uint64_t sequence = m_header->cursor.load(std::memory_order_relaxed);
+        // Only look at the reader cursors if the cached gating sequence would be overrun
+        if (sequence - m_gating >= m_slots) {
+            waitForReaders(sequence);
+        }
+        char* slot = slotOf(sequence);
+        Entry entry = { static_cast<uint32_t>(id.size()), static_cast<uint32_t>(msg.size()) };
+        std::memcpy(slot, &entry, sizeof(Entry));
+        std::memcpy(slot + sizeof(Entry), id.data(), id.size());
+        std::memcpy(slot + sizeof(Entry) + id.size(), msg.data(), msg.size());
+        // Sequentially consistent with the waiter count of sleeping readers, see handleRead()
+        m_header->cursor.store(sequence + 1, std::memory_order_seq_cst);
+        if (m_header->waiters.load(std::memory_order_seq_cst) > 0) {
+            m_header->signal.fetch_add(1, std::memory_order_seq_cst);
+            futex(&m_header->signal, FUTEX_WAKE, INT_MAX, nullptr);
+        }
+    }
+
+    /*
+     * \brief Get the sequence of the next published message
+     */
+    uint64_t cursor() const {
+        return m_header->cursor.load(std::memory_order_acquire);
+    }
+
+private:
+    /*
+     * \brief Cursor of an attached reader, on its own cache line
+     */
+    struct alignas(64) Reader {
+        // Sequence of the next message the reader processes
+        std::atomic<uint64_t> sequence;
+        // Process of the reader, 0 if the entry is free, -1 while it is claimed
+        std::atomic<int32_t> pid;
+    };
+
+    /*
+     * \brief Ring state at the start of the file
+     */
+    struct Header {
+        std::atomic<uint64_t> magic;
+        uint64_t slots;
+        uint64_t slotSize;
+        // Sequence of the next published message
+        alignas(64) std::atomic<uint64_t> cursor;
+        // Number of sleeping readers
+        alignas(64) std::atomic<uint32_t> waiters;
+        // Futex word incremented by the writer to wake sleeping readers
+        std::atomic<uint32_t> signal;
+        Reader readers[MAX_READERS];
+    };
+
+    /*
+     * \brief Header of a slot, followed by identifier and message
+     */
+    struct Entry {
+        uint32_t idLength;
+        uint32_t msgLength;
+    };
+
+    // Access type
+    PipeAccess m_access;
+    // Tuning parameters
+    PipeConfig m_config;
+    // Mapped ring file
+    MappedFile m_file;
+    // Ring state
+    Header* m_header;
+    // Number of slots
+    size_t m_slots;
+    // Size of a slot
+    size_t m_slotSize;
+    // Cursor of this reader
+    Reader* m_reader;
+    // Writer: cached sequence of the slowest reader
+    uint64_t m_gating;
+    // Mutex serializing writers
+    std::mutex m_writeMutex;
+    // Atomic boolean to notify reader thread of exit
+    std::atomic<bool> m_hasToStop;
+    // Reader thread
+    std::thread m_thread;
+    // Map of message identifiers associated with its callback
+    std::map<std::string, Callback, std::less<>> m_callbacks;
+    // Map of message identifiers associated with its in-place callback
+    std::map<std::string, ViewCallback, std::less<>> m_viewCallbacks;
+
+    static long futex(std::atomic<uint32_t>* word, int operation, uint32_t value, struct timespec const* timeout) {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), operation, value, timeout, nullptr, 0);
+    }
+
+    char* slotOf(uint64_t sequence) const {
+        return m_file.data() + sizeof(Header) + (sequence % m_slots) * m_slotSize;
+    }
+
+    void checkCallback(std::string const& id) const {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to add a callback on ring with write access only.");
+        }
+        // Check if callback already present
+        if (m_callbacks.find(id) != m_callbacks.end() || m_viewCallbacks.find(id) != m_viewCallbacks.end()) {
+            throw std::logic_error("Tried to add a second callback for the same identifier.");
+        }
+    }
+
+    /*
+     * \brief Claim a reader cursor starting at the current writer cursor
+     */
+    void attach() {
+        for (Reader& reader : m_header->readers) {
+            int32_t free = 0;
+            if (reader.pid.compare_exchange_strong(free, -1)) {
+                // Joining at or after the gating sequence cached by the writer keeps our slots safe from reuse
+                reader.sequence.store(m_header->cursor.load(std::memory_order_acquire), std::memory_order_release);
+                reader.pid.store(getpid(), std::memory_order_release);
+                m_reader = &reader;
+                return;
+            }
+        }
+        throw std::logic_error("Tried to attach more than MAX_READERS readers to a ring.");
+    }
+
+    /*
+     * \brief Compute the sequence of the slowest reader, releasing cursors of readers whose process is gone
+     * \param sequence Current writer cursor
+     */
+    uint64_t slowestReader(uint64_t sequence, bool reap) {
+        uint64_t slowest = sequence;
+        for (Reader& reader : m_header->readers) {
+            int32_t pid = reader.pid.load(std::memory_order_acquire);
+            if (pid == 0) {
+                continue;
+            }
+            if (reap && pid > 0 && kill(pid, 0) == -1 && errno == ESRCH) {
+                reader.pid.compare_exchange_strong(pid, 0);
+                continue;
+            }
+            slowest = std::min(slowest, reader.sequence.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+    /*
+     * \brief Wait until the slot of the given sequence is no longer used by any reader
+     * \param sequence Sequence to publish
+     */
+    void waitForReaders(uint64_t sequence) {
+        size_t spins = 0;
+        auto reapTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(POLL_TIMEOUT_MS);
+        bool reap = false;
+        while ((m_gating = slowestReader(sequence, reap)) + m_slots <= sequence) {
+            reap = false;
+            if (spins++ < m_config.spinBudget) {
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            // Readers that crashed would block the writer forever
+            if (std::chrono::steady_clock::now() >= reapTime) {
+                reap = true;
+                reapTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(POLL_TIMEOUT_MS);
+            }
+        }
+    }
+
+    /*
+     * \brief Call the callback registered for the message in a slot
+     */
+    void dispatch(char const* slot) {
+        Entry entry;
+        std::memcpy(&entry, slot, sizeof(Entry));
+        std::string_view id(slot + sizeof(Entry), entry.idLength);
+        std::string_view msg(slot + sizeof(Entry) + entry.idLength, entry.msgLength);
+        auto viewCallback = m_viewCallbacks.find(id);
+        if (viewCallback != m_viewCallbacks.end()) {
+            viewCallback->second(msg);
+            return;
+        }
+        auto callback = m_callbacks.find(id);
+        if (callback != m_callbacks.end()) {
+            callback->second(std::string(msg));
+        }
+    }
+
+    /*
+     * \brief Main reader thread routine that processes all published messages in batches
+     */
+    void handleRead() {
+        uint64_t next = m_reader->sequence.load(std::memory_order_relaxed);
+        size_t spins = 0;
+        struct timespec timeout = { 0, POLL_TIMEOUT_MS * 1000000L };
+        while (!m_hasToStop) {
+            uint64_t available = m_header->cursor.load(std::memory_order_acquire);
+            if (next < available) {
+                // Process everything published so far, then release the slots to the writer at once
+                for (; next < available; ++next) {
+                    dispatch(slotOf(next));
+                }
+                m_reader->sequence.store(next, std::memory_order_release);
+                spins = 0;
+            } else if (spins++ >= m_config.spinBudget) {
+                // Announce sleeping before the final check so the writer either sees us or we see its message
+                m_header->waiters.fetch_add(1, std::memory_order_seq_cst);
+                uint32_t signal = m_header->signal.load(std::memory_order_seq_cst);
+                if (m_header->cursor.load(std::memory_order_seq_cst) == next) {
+                    futex(&m_header->signal, FUTEX_WAIT, signal, &timeout);
+                }
+                m_header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+                spins = 0;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * \brief Process-wide pool of receive buffers shared by all pipes
+ *
+ * Hibernating pipes hand their receive buffer back, pipes waking up take one out.
+ * Buffers are kept per power of two size class and only as many as are recycled
+ * concurrently, so the pool stays small even with many idle pipes.
+ */
+class BufferPool {
+public:
+    // Number of size classes, the largest pooled buffer has 2^(SIZE_CLASSES - 1) bytes
+    static constexpr size_t const SIZE_CLASSES = 24;
+    // Maximum number of pooled buffers per size class
+    static constexpr size_t const MAX_POOLED = 64;
+
+    /*
+     * \brief Get the pool of the process
+     */
+    static BufferPool& instance() {
+        static BufferPool pool;
+        return pool;
+    }
+
+    /*
+     * \brief Take a buffer out of the pool or allocate a new one
+     * \param size Size of the buffer
+     */
+    std::string acquire(size_t size) {
+        size_t sizeClass = classOf(size);
+        std::string buffer;
+        if (sizeClass < SIZE_CLASSES) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free[sizeClass].empty()) {
+                buffer = std::move(m_free[sizeClass].back());
+                m_free[sizeClass].pop_back();
+            }
+        }
+        if (buffer.capacity() < size && sizeClass < SIZE_CLASSES) {
+            buffer.reserve(size_t(1) << sizeClass);
+        }
+        // Pooled buffers have the capacity of their class, resizing them does not allocate
+        buffer.resize(size, '\0');
+        return buffer;
+    }
+
+    /*
+     * \brief Hand a buffer back to the pool, it is freed if the pool is full
+     * \param buffer Buffer to recycle
+     */
+    void release(std::string buffer) {
+        // Pooled in the largest class the capacity covers, small strings live inline and are not worth pooling
+        size_t sizeClass = classOf(buffer.capacity() + 1) - 1;
+        if (sizeClass >= SIZE_CLASSES || buffer.capacity() <= sizeof(std::string)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free[sizeClass].size() < MAX_POOLED) {
+            m_free[sizeClass].push_back(std::move(buffer));
+        }
+    }
+
+    /*
+     * \brief Free all pooled buffers, called under memory pressure
+     */
+    void trim() {
+        std::vector<std::string> freed[SIZE_CLASSES];
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t sizeClass = 0; sizeClass < SIZE_CLASSES; ++sizeClass) {
+                freed[sizeClass].swap(m_free[sizeClass]);
+            }
+        }
+    }
+
+private:
+    // Pooled buffers per size class
+    std::vector<std::string> m_free[SIZE_CLASSES];
+    // Guards the free lists
+    std::mutex m_mutex;
+
+    /*
+     * \brief Smallest size class holding the given number of bytes
+     */
+    static size_t classOf(size_t size) {
+        size_t sizeClass = 0;
+        while ((size_t(1) << sizeClass) < size) {
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+};
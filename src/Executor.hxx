@@ -0,0 +1,301 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "SlabAllocator.hxx"
+
+/*
+ * \brief Thread running the callbacks a reader pipe routes to it
+ *
+ * Every reader pipe with callbacks on the executor owns one single-producer single-consumer
+ * inbox of it: the reader thread of the pipe copies matching messages into a slab block and
+ * links it into the inbox, the executor thread runs the callback and recycles the block. The
+ * executor either runs its own thread (start()) or is driven by an existing thread calling
+ * poll() until prepareSleep() returns true, then waiting for fd() to become readable and
+ * calling wakeUp(). Pipes with callbacks on an executor have to be destroyed before it.
+ */
+class Executor {
+public:
+    // Timeout in milliseconds after which the executor thread checks for stop requests
+    static constexpr int const POLL_TIMEOUT_MS = 100;
+
+    /*
+     * \brief Inbox of the messages of one reader pipe
+     */
+    class Inbox {
+    public:
+        // Calls the handler with the message content
+        using Invoke = void (*)(void const* handler, std::string_view content);
+
+        explicit Inbox(Executor& executor) : m_executor(executor), m_tail(&m_stub), m_head(&m_stub), m_closed(false) {
+            m_stub.next.store(nullptr, std::memory_order_relaxed);
+        }
+
+        Inbox(Inbox const&) = delete;
+        Inbox& operator=(Inbox const&) = delete;
+
+        /*
+         * \brief Recycle messages the executor did not run anymore
+         */
+        ~Inbox() {
+            Node* node = m_head;
+            while (node != nullptr) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                release(node);
+                node = next;
+            }
+        }
+
+        /*
+         * \brief Queue a copy of a message, only called by the reader thread of the pipe
+         * \param invoke Function calling the handler
+         * \param handler Handler of the message, has to live until the inbox is detached
+         * \param content Message content
+         */
+        void push(Invoke invoke, void const* handler, std::string_view content) {
+            Node* node = new (m_slab.allocate(sizeof(Node) + content.size())) Node();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->invoke = invoke;
+            node->handler = handler;
+            std::memcpy(node->data(), content.data(), content.size());
+            node->content = std::string_view(node->data(), content.size());
+            // Sequentially consistent with the sleep announcement in Executor::prepareSleep()
+            m_tail->next.store(node, std::memory_order_seq_cst);
+            m_tail = node;
+            m_executor.notify();
+        }
+
+    private:
+        friend class Executor;
+
+        /*
+         * \brief Queued message, content follows in the same slab block
+         */
+        struct Node {
+            // Next queued message
+            std::atomic<Node*> next;
+            // Function calling the handler
+            Invoke invoke;
+            // Handler of the message
+            void const* handler;
+            // Message content
+            std::string_view content;
+
+            char* data() {
+                return reinterpret_cast<char*>(this + 1);
+            }
+        };
+
+        // Executor running the messages
+        Executor& m_executor;
+        // Initial empty node
+        Node m_stub;
+        // Newest queued message, only used by the producer
+        alignas(64) Node* m_tail;
+        // Last run message or the stub, only used by the consumer
+        alignas(64) Node* m_head;
+        // Set once the pipe detached, remaining messages are dropped
+        std::atomic<bool> m_closed;
+        // Storage of queued messages, destroyed after them
+        SlabAllocator m_slab;
+
+        /*
+         * \brief Check if messages are queued, only called by the consumer
+         */
+        bool pending() const {
+            return m_head->next.load(std::memory_order_seq_cst) != nullptr;
+        }
+
+        /*
+         * \brief Run all queued messages, only called by the consumer
+         * \return Number of run messages
+         */
+        size_t drain() {
+            size_t count = 0;
+            while (!m_closed.load(std::memory_order_acquire)) {
+                Node* next = m_head->next.load(std::memory_order_acquire);
+                if (next == nullptr) {
+                    break;
+                }
+                // The message becomes the new stub, its predecessor is no longer referenced
+                release(m_head);
+                m_head = next;
+                next->invoke(next->handler, next->content);
+                ++count;
+            }
+            return count;
+        }
+
+        void release(Node* node) {
+            if (node != &m_stub) {
+                node->~Node();
+                m_slab.deallocate(node);
+            }
+        }
+    };
+
+    Executor() : m_eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_sleeping(false), m_hasToStop(false) {
+        if (m_eventFd == -1) {
+            perror("eventfd");
+            abort();
+        }
+    }
+
+    Executor(Executor const&) = delete;
+    Executor& operator=(Executor const&) = delete;
+
+    /*
+     * \brief Stop the executor thread, queued messages are dropped
+     */
+    ~Executor() {
+        if (m_thread && m_thread->joinable()) {
+            m_hasToStop = true;
+            signal();
+            m_thread->join();
+        }
+        close(m_eventFd);
+    }
+
+    /*
+     * \brief Run the callbacks on a thread of the executor
+     */
+    void start() {
+        if (!m_thread) {
+            m_thread.reset(new std::thread(&Executor::run, this));
+        }
+    }
+
+    /*
+     * \brief Run all queued messages on the calling thread, the thread driving the executor
+     * \return Number of run messages
+     */
+    size_t poll() {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        size_t count = 0;
+        // Holds the inbox in case a callback detaches it
+        for (size_t idx = 0; idx < m_inboxes.size(); ++idx) {
+            std::shared_ptr<Inbox> inbox = m_inboxes[idx];
+            count += inbox->drain();
+        }
+        return count;
+    }
+
+    /*
+     * \brief Announce that the driving thread is going to wait for fd()
+     * \return False if messages are queued and the thread has to poll() instead
+     */
+    bool prepareSleep() {
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        for (std::shared_ptr<Inbox> const& inbox : m_inboxes) {
+            if (inbox->pending()) {
+                m_sleeping.store(false, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * \brief Driving thread woke up, consume pending signals
+     */
+    void wakeUp() {
+        m_sleeping.store(false, std::memory_order_relaxed);
+        // A single read resets the counter of the eventfd
+        uint64_t count;
+        if (::read(m_eventFd, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+            perror("read(eventfd)");
+        }
+    }
+
+    /*
+     * \brief Get the eventfd the driving thread waits for while sleeping
+     */
+    int fd() const {
+        return m_eventFd;
+    }
+
+    /*
+     * \brief Create the inbox of a reader pipe
+     */
+    std::shared_ptr<Inbox> attach() {
+        std::shared_ptr<Inbox> inbox = std::make_shared<Inbox>(*this);
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_inboxes.push_back(inbox);
+        return inbox;
+    }
+
+    /*
+     * \brief Remove the inbox of a reader pipe whose reader stopped, waits for a running callback of another thread
+     */
+    void detach(std::shared_ptr<Inbox> const& inbox) {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        inbox->m_closed.store(true, std::memory_order_release);
+        m_inboxes.erase(std::remove(m_inboxes.begin(), m_inboxes.end(), inbox), m_inboxes.end());
+    }
+
+private:
+    // Wakes the sleeping executor
+    int m_eventFd;
+    // True while the executor sleeps or is about to
+    std::atomic<bool> m_sleeping;
+    // Stops the executor thread
+    std::atomic<bool> m_hasToStop;
+    // Guards the inboxes, held while running callbacks
+    std::recursive_mutex m_mutex;
+    // Inboxes of all attached pipes
+    std::vector<std::shared_ptr<Inbox>> m_inboxes;
+    // Executor thread, if started
+    std::unique_ptr<std::thread> m_thread;
+
+    /*
+     * \brief Wake the executor if it sleeps, called after queueing a message
+     */
+    void notify() {
+        if (m_sleeping.load(std::memory_order_seq_cst)) {
+            signal();
+        }
+    }
+
+    void signal() {
+        uint64_t one = 1;
+        if (::write(m_eventFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+            perror("write(eventfd)");
+        }
+    }
+
+    /*
+     * \brief Executor thread routine
+     */
+    void run() {
+        struct pollfd pfd = { m_eventFd, POLLIN, 0 };
+        while (!m_hasToStop) {
+            if (poll() > 0) {
+                continue;
+            }
+            if (prepareSleep()) {
+                ::poll(&pfd, 1, POLL_TIMEOUT_MS);
+                wakeUp();
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * \brief Running histogram of received frame sizes with power of two buckets
+ *
+ * Counts are halved every DECAY_INTERVAL samples, so the distribution follows changes of the
+ * traffic while recording stays a few instructions. Each bucket also keeps the largest size it
+recorded, so percentiles are exact for frames of one size instead of rounded up to the bucket
+bound. Only used by the reader thread.
+ */
+class FrameSizeHistogram {
+public:
+    // Number of buckets, bucket b counts frames of up to 2^b bytes
+    static constexpr size_t const BUCKETS = 48;
+    // Number of samples after which all counts are halved
+    static constexpr uint32_t const DECAY_INTERVAL = 4096;
+
+    FrameSizeHistogram() : m_counts(), m_largest(), m_total(0), m_samples(0) {}
+
+    /*
+     * \brief Record the size of a received frame
+     */
+    void record(size_t bytes) {
+        size_t bucket = bucketOf(bytes);
+        ++m_counts[bucket];
+        if (bytes > m_largest[bucket]) {
+            m_largest[bucket] = bytes;
+        }
+        ++m_total;
+        if (++m_samples == DECAY_INTERVAL) {
+            m_samples = 0;
+            m_total = 0;
+            for (size_t b = 0; b < BUCKETS; ++b) {
+                m_counts[b] /= 2;
+                m_total += m_counts[b];
+                // Buckets decayed to nothing forget their largest frame
+                if (m_counts[b] == 0) {
+                    m_largest[b] = 0;
+                }
+            }
+        }
+    }
+
+    /*
+     * \brief Get the number of frames the histogram currently weighs
+     */
+    uint64_t count() const {
+        return m_total;
+    }
+
+    /*
+     * \brief Get the largest recorded size in the bucket of the given percentile, 0 if nothing was recorded
+     * \param p Percentile in range [0, 100]
+     */
+    size_t percentile(double p) const {
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * m_total + 0.5);
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += m_counts[bucket];
+            if (seen > 0 && seen >= rank) {
+                return m_largest[bucket];
+            }
+        }
+        return 0;
+    }
+
+private:
+    // Frames per bucket
+    uint32_t m_counts[BUCKETS];
+    // Largest frame recorded per bucket since it was last empty
+    size_t m_largest[BUCKETS];
+    // Sum of all counts
+    uint64_t m_total;
+    // Samples since the last decay
+    uint32_t m_samples;
+
+    /*
+     * \brief Get the smallest bucket whose bound holds the given size
+     */
+    static size_t bucketOf(size_t bytes) {
+        size_t bucket = bytes > 1 ? 64 - __builtin_clzll(static_cast<unsigned long long>(bytes - 1)) : 0;
+        return bucket < BUCKETS ? bucket : BUCKETS - 1;
+    }
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * \brief Traffic of a single message identifier
+ */
+struct IdTraffic {
+    // Message identifier (truncated to IdStatistics::MAX_ID_LENGTH)
+    std::string id;
+    // Number of messages
+    uint64_t messages;
+    // Number of bytes including framing
+    uint64_t bytes;
+    // True if counted exactly, false if estimated by the heavy hitter tracking
+    bool exact;
+};
+
+/*
+ * \brief Lock-free per identifier message and byte counters
+ *
+ * The first identifiers are counted exactly in a fixed open addressing table.
+ * Once it is full, further identifiers are counted in a count-min sketch and the
+ * heaviest of them (by bytes) are tracked in a space-saving top-K table. All
+ * updates use atomics only, so writers of any thread and the reader thread may
+ * record concurrently while snapshot() is taken.
+ */
+class IdStatistics {
+public:
+    // Maximum stored length of an identifier, longer ones are distinguished by hash only
+    static constexpr size_t const MAX_ID_LENGTH = 48;
+
+    /*
+     * \brief Create statistics
+     * \param exactCapacity Number of identifiers counted exactly
+     * \param topK Number of heavy hitters tracked beyond the exact identifiers
+     * \param sketchWidth Number of counters per count-min sketch row
+     * \param sketchDepth Number of count-min sketch rows
+     */
+    explicit IdStatistics(size_t exactCapacity = 64, size_t topK = 16, size_t sketchWidth = 1024, size_t sketchDepth = 4)
+        : m_exact(new Slot[exactCapacity]), m_exactCapacity(exactCapacity),
+          m_heavy(new Slot[topK]), m_topK(topK),
+          m_sketch(new std::atomic<uint64_t>[sketchWidth * sketchDepth]), m_sketchWidth(sketchWidth), m_sketchDepth(sketchDepth) {
+        for (size_t idx = 0; idx < sketchWidth * sketchDepth; ++idx) {
+            m_sketch[idx].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * \brief Count a message
+     * \param id Message identifier
+     * \param bytes Size of the message in bytes
+     */
+    void record(std::string_view id, size_t bytes) {
+        uint64_t hash = hashOf(id);
+        // Exact table with linear probing, slots are claimed once and never released
+        for (size_t probe = 0; probe < m_exactCapacity; ++probe) {
+            Slot& slot = m_exact[(hash + probe) % m_exactCapacity];
+            uint64_t current = slot.hash.load(std::memory_order_acquire);
+            if (current == 0 && slot.hash.compare_exchange_strong(current, hash, std::memory_order_acq_rel)) {
+                slot.storeId(id);
+                slot.version.store(2, std::memory_order_release);
+                current = hash;
+            }
+            if (current == hash) {
+                slot.messages.fetch_add(1, std::memory_order_relaxed);
+                slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+                return;
+            }
+        }
+        recordHeavy(id, hash, bytes);
+    }
+
+    /*
+     * \brief Get the exactly counted identifiers and the current heavy hitters, ordered by bytes
+     */
+    std::vector<IdTraffic> snapshot() const {
+        std::vector<IdTraffic> result;
+        for (size_t idx = 0; idx < m_exactCapacity; ++idx) {
+            IdTraffic traffic;
+            if (m_exact[idx].load(traffic)) {
+                traffic.exact = true;
+                result.push_back(traffic);
+            }
+        }
+        for (size_t idx = 0; idx < m_topK; ++idx) {
+            IdTraffic traffic;
+            if (m_heavy[idx].load(traffic)) {
+                traffic.exact = false;
+                result.push_back(traffic);
+            }
+        }
+        std::sort(result.begin(), result.end(), [](IdTraffic const& lhs, IdTraffic const& rhs) {
+            return lhs.bytes > rhs.bytes;
+        });
+        return result;
+    }
+
+private:
+    // Number of 64 bit words holding an identifier
+    static constexpr size_t const ID_WORDS = MAX_ID_LENGTH / sizeof(uint64_t);
+
+    /*
+     * \brief Counter slot guarded by a sequence lock for identifier replacement
+     */
+    struct Slot {
+        // Hash of the identifier, 0 if unused
+        std::atomic<uint64_t> hash{0};
+        // Even if stable, odd while the identifier is replaced, 0 while unused
+        std::atomic<uint64_t> version{0};
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> length{0};
+        std::atomic<uint64_t> words[ID_WORDS] = {};
+
+        /*
+         * \brief Store identifier, truncated to MAX_ID_LENGTH
+         */
+        void storeId(std::string_view id) {
+            size_t length = std::min(id.size(), MAX_ID_LENGTH);
+            for (size_t word = 0; word < ID_WORDS; ++word) {
+                uint64_t value = 0;
+                for (size_t byte = 0; byte < sizeof(uint64_t) && word * sizeof(uint64_t) + byte < length; ++byte) {
+                    value |= static_cast<uint64_t>(static_cast<unsigned char>(id[word * sizeof(uint64_t) + byte])) << (8 * byte);
+                }
+                words[word].store(value, std::memory_order_relaxed);
+            }
+            this->length.store(length, std::memory_order_relaxed);
+        }
+
+        /*
+         * \brief Load a consistent copy of the slot, false if unused
+         */
+        bool load(IdTraffic& traffic) const {
+            while (true) {
+                uint64_t before = version.load(std::memory_order_acquire);
+                if (before == 0) {
+                    return false;
+                } else if (before % 2 == 1) {
+                    continue;
+                }
+                traffic.id.resize(length.load(std::memory_order_relaxed));
+                for (size_t idx = 0; idx < traffic.id.size(); ++idx) {
+                    traffic.id[idx] = static_cast<char>(words[idx / sizeof(uint64_t)].load(std::memory_order_relaxed) >> (8 * (idx % sizeof(uint64_t))));
+                }
+                traffic.messages = messages.load(std::memory_order_relaxed);
+                traffic.bytes = bytes.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version.load(std::memory_order_relaxed) == before) {
+                    return true;
+                }
+            }
+        }
+    };
+
+    // Exactly counted identifiers
+    std::unique_ptr<Slot[]> m_exact;
+    size_t m_exactCapacity;
+    // Space-saving heavy hitter table
+    std::unique_ptr<Slot[]> m_heavy;
+    size_t m_topK;
+    // Count-min sketch of bytes per identifier, m_sketchDepth rows of m_sketchWidth counters
+    std::unique_ptr<std::atomic<uint64_t>[]> m_sketch;
+    size_t m_sketchWidth;
+    size_t m_sketchDepth;
+
+    /*
+     * \brief Non-zero 64 bit hash of an identifier
+     */
+    static uint64_t hashOf(std::string_view id) {
+        uint64_t hash = std::hash<std::string_view>()(id);
+        return hash == 0 ? 1 : hash;
+    }
+
+    /*
+     * \brief Derive the column of a sketch row from the identifier hash
+     */
+    size_t column(uint64_t hash, size_t row) const {
+        uint64_t mixed = hash + (row + 1) * 0x9e3779b97f4a7c15ull;
+        mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+        return (mixed ^ (mixed >> 31)) % m_sketchWidth;
+    }
+
+    /*
+     * \brief Count an identifier that did not fit into the exact table
+     */
+    void recordHeavy(std::string_view id, uint64_t hash, size_t bytes) {
+        // Update the sketch and get the estimated total of the identifier
+        uint64_t estimate = UINT64_MAX;
+        for (size_t row = 0; row < m_sketchDepth; ++row) {
+            uint64_t value = m_sketch[row * m_sketchWidth + column(hash, row)].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            estimate = std::min(estimate, value);
+        }
+        // Already tracked as heavy hitter
+        Slot* minimum = nullptr;
+        uint64_t minimumBytes = UINT64_MAX;
+        for (size_t idx = 0; idx < m_topK; ++idx) {
+            Slot& slot = m_heavy[idx];
+            if (slot.hash.load(std::memory_order_acquire) == hash) {
+                slot.messages.fetch_add(1, std::memory_order_relaxed);
+                slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+                return;
+            }
+            uint64_t slotBytes = slot.bytes.load(std::memory_order_relaxed);
+            if (slotBytes < minimumBytes) {
+                minimumBytes = slotBytes;
+                minimum = &slot;
+            }
+        }
+        // Replace the lightest entry if the identifier is estimated to be heavier, give up if it is being replaced concurrently
+        if (minimum == nullptr || estimate <= minimumBytes) {
+            return;
+        }
+        uint64_t version = minimum->version.load(std::memory_order_relaxed);
+        if (version % 2 == 1 || !minimum->version.compare_exchange_strong(version, version + 1, std::memory_order_acquire)) {
+            return;
+        }
+        minimum->hash.store(hash, std::memory_order_relaxed);
+        minimum->storeId(id);
+        minimum->bytes.store(estimate, std::memory_order_relaxed);
+        minimum->messages.store(std::max<uint64_t>(1, estimate / std::max<size_t>(bytes, 1)), std::memory_order_relaxed);
+        minimum->version.store(version + 2, std::memory_order_release);
+    }
+};
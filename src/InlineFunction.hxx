@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature, size_t Capacity = 64>
+class InlineFunction;
+
+/*
+ * \brief Move-only callable wrapper storing the callable inline without heap allocation
+ *
+ * Works like std::function, but callables larger than Capacity bytes are rejected
+ * at compile time instead of being moved to the heap.
+ */
+template<typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+public:
+    /*
+     * \brief Create empty function
+     */
+    InlineFunction() noexcept : m_invoke(nullptr), m_manage(nullptr) {}
+
+    /*
+     * \brief Create function from callable
+     * \param callable Callable to store inline
+     */
+    template<typename F, typename Fn = std::decay_t<F>, typename = std::enable_if_t<!std::is_same<Fn, InlineFunction>::value>>
+    InlineFunction(F&& callable) : m_invoke(&invoke<Fn>), m_manage(&manage<Fn>) {
+        static_assert(sizeof(Fn) <= Capacity, "Callable does not fit into the inline storage.");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "Callable requires an unsupported alignment.");
+        static_assert(std::is_nothrow_move_constructible<Fn>::value, "Callable has to be nothrow move constructible.");
+        new (m_storage) Fn(std::forward<F>(callable));
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept : m_invoke(other.m_invoke), m_manage(other.m_manage) {
+        if (m_manage) {
+            m_manage(m_storage, other.m_storage);
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.m_manage) {
+                other.m_manage(m_storage, other.m_storage);
+                m_invoke = other.m_invoke;
+                m_manage = other.m_manage;
+                other.m_invoke = nullptr;
+                other.m_manage = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineFunction(InlineFunction const&) = delete;
+    InlineFunction& operator=(InlineFunction const&) = delete;
+
+    ~InlineFunction() {
+        reset();
+    }
+
+    /*
+     * \brief Check if a callable is stored
+     */
+    explicit operator bool() const noexcept {
+        return m_invoke != nullptr;
+    }
+
+    /*
+     * \brief Call the stored callable
+     */
+    R operator()(Args... args) const {
+        return m_invoke(const_cast<unsigned char*>(m_storage), std::forward<Args>(args)...);
+    }
+
+private:
+    // Inline storage of the callable
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+    // Calls the stored callable
+    R (*m_invoke)(void*, Args&&...);
+    // Moves the callable from source to destination storage and destroys the source, destroys only if destination is nullptr
+    void (*m_manage)(void*, void*);
+
+    template<typename Fn>
+    static R invoke(void* storage, Args&&... args) {
+        return (*static_cast<Fn*>(storage))(std::forward<Args>(args)...);
+    }
+
+    template<typename Fn>
+    static void manage(void* destination, void* source) {
+        Fn* callable = static_cast<Fn*>(source);
+        if (destination) {
+            new (destination) Fn(std::move(*callable));
+        }
+        callable->~Fn();
+    }
+
+    /*
+     * \brief Destroy the stored callable
+     */
+    void reset() {
+        if (m_manage) {
+            m_manage(nullptr, m_storage);
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+    }
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "SlabAllocator.hxx"
+
+/*
+ * \brief In-process channel replacing a named pipe whose reader lives in the same process
+ *
+ * Messages are passed unframed through a lock-free multi-producer single-consumer queue
+ * (Vyukov's intrusive queue). The reader sleeps in poll on the eventfd of the channel,
+ * writers only signal it if the reader announced that it is about to sleep. Each message
+ * is stored with its identifier and content in one block of the slab allocator of the
+ * channel and recycled once the reader is done with it. The queued blocks are counted, so
+ * writers can wait for room like on a full pipe.
+ */
+class LocalChannel {
+public:
+    // Bytes of queued blocks after which writers wait if none is configured, the default capacity of a Linux pipe
+    static constexpr size_t const DEFAULT_CAPACITY = 65536;
+
+    /*
+     * \brief Queued message
+     */
+    struct Message {
+        // Next queued message
+        std::atomic<Message*> next;
+        // Message identifier
+        std::string_view id;
+        // Message content
+        std::string_view content;
+
+        /*
+         * \brief Get the storage of identifier and content, following the message in its block
+         */
+        char* data() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    LocalChannel() : m_head(&m_stub), m_queued(0), m_tail(&m_stub), m_reader(false), m_sleeping(false), m_waiting(0),
+          m_eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+        if (m_eventFd == -1) {
+            perror("eventfd");
+            abort();
+        }
+    }
+
+    LocalChannel(LocalChannel const&) = delete;
+    LocalChannel& operator=(LocalChannel const&) = delete;
+
+    ~LocalChannel() {
+        // Popping frees all but the last message
+        while (pop() != nullptr) {}
+        if (m_tail != &m_stub) {
+            m_tail->~Message();
+            m_slab.deallocate(m_tail);
+        }
+        close(m_eventFd);
+    }
+
+    /*
+     * \brief Get the channel of a named pipe, shared by all pipes of the process opened with the same path
+     * \param path Path of the existing named pipe
+     */
+    static std::shared_ptr<LocalChannel> attach(std::string const& path) {
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<LocalChannel>> registry;
+        // Resolve links and relative paths so all names of the same pipe share the channel
+        char resolved[PATH_MAX];
+        std::string key = realpath(path.c_str(), resolved) != nullptr ? std::string(resolved) : path;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<LocalChannel> channel = registry[key].lock();
+        if (!channel) {
+            channel = std::make_shared<LocalChannel>();
+            registry[key] = channel;
+        }
+        return channel;
+    }
+
+    /*
+     * \brief Mark the reader of the channel as present or gone
+     */
+    void setReader(bool present) {
+        m_reader.store(present, std::memory_order_release);
+        // Writers waiting for room fall back to the named pipe
+        if (!present) {
+            std::lock_guard<std::mutex> lock(m_spaceMutex);
+            m_space.notify_all();
+        }
+    }
+
+    /*
+     * \brief Check if a reader of this process is attached, writers then use the channel
+     */
+    bool hasReader() const {
+        return m_reader.load(std::memory_order_acquire);
+    }
+
+    /*
+     * \brief Create a message to be filled and queued with push()
+     * \param id Message identifier
+     * \param length Length of the content, written by the caller to data() + id.size()
+     */
+    Message* create(std::string_view id, size_t length) {
+        m_queued.fetch_add(sizeof(Message) + id.size() + length, std::memory_order_relaxed);
+        Message* msg = new (m_slab.allocate(sizeof(Message) + id.size() + length)) Message();
+        msg->next.store(nullptr, std::memory_order_relaxed);
+        std::memcpy(msg->data(), id.data(), id.size());
+        msg->id = std::string_view(msg->data(), id.size());
+        msg->content = std::string_view(msg->data() + id.size(), length);
+        return msg;
+    }
+
+    /*
+     * \brief Queue a copy of a message, wakes the reader if it sleeps
+     * \param id Message identifier
+     * \param content Message content
+     */
+    void push(std::string_view id, std::string_view content) {
+        Message* msg = create(id, content.size());
+        std::memcpy(msg->data() + id.size(), content.data(), content.size());
+        push(msg);
+    }
+
+    /*
+     * \brief Queue a message created by create(), wakes the reader if it sleeps
+     */
+    void push(Message* msg) {
+        Message* previous = m_head.exchange(msg, std::memory_order_acq_rel);
+        previous->next.store(msg, std::memory_order_seq_cst);
+        // Sequentially consistent with the sleep announcement in prepareSleep()
+        if (m_sleeping.load(std::memory_order_seq_cst)) {
+            uint64_t one = 1;
+            if (::write(m_eventFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+                perror("write(eventfd)");
+            }
+        }
+    }
+
+    /*
+     * \brief Take the oldest message, only called by the reader
+     * \return Message or nullptr if empty, valid until the next call
+     */
+    Message* pop() {
+        Message* tail = m_tail;
+        Message* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return nullptr;
+        }
+        // The popped message becomes the new stub, its predecessor is no longer referenced
+        m_tail = next;
+        release(tail);
+        // Sequentially consistent with the wait announcement in waitRoom()
+        m_queued.fetch_sub(sizeof(Message) + next->id.size() + next->content.size(), std::memory_order_seq_cst);
+        if (m_waiting.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(m_spaceMutex);
+            m_space.notify_all();
+        }
+        return next;
+    }
+
+    /*
+     * \brief Check if the queued messages take at least the given number of bytes
+     * \param capacity Bytes of queued blocks after which the queue counts as full
+     */
+    bool full(size_t capacity) const {
+        return m_queued.load(std::memory_order_relaxed) >= capacity;
+    }
+
+    /*
+     * \brief Wait until the queue has room, the reader left or the time ran out
+     * \param capacity Bytes of queued blocks after which the queue counts as full
+     * \param timeoutMs Maximum time to wait
+     */
+    void waitRoom(size_t capacity, int timeoutMs) {
+        std::unique_lock<std::mutex> lock(m_spaceMutex);
+        m_waiting.fetch_add(1, std::memory_order_seq_cst);
+        m_space.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this, capacity]() {
+            return m_queued.load(std::memory_order_seq_cst) < capacity || !hasReader();
+        });
+        m_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Announce that the reader is going to sleep
+     * \return False if messages are queued and the reader has to continue instead
+     */
+    bool prepareSleep() {
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        if (m_tail->next.load(std::memory_order_seq_cst) != nullptr) {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * \brief Reader woke up, consume pending signals
+     */
+    void wakeUp() {
+        m_sleeping.store(false, std::memory_order_relaxed);
+        uint64_t count;
+        while (::read(m_eventFd, &count, sizeof(count)) > 0) {}
+    }
+
+    /*
+     * \brief Get the eventfd the reader polls while sleeping
+     */
+    int eventFd() const {
+        return m_eventFd;
+    }
+
+    /*
+     * \brief Get the allocator of queued messages
+     */
+    SlabAllocator const& slab() const {
+        return m_slab;
+    }
+
+private:
+    // Initial empty node of the queue
+    Message m_stub;
+    // Newest queued message, written by all writers
+    alignas(64) std::atomic<Message*> m_head;
+    // Bytes of the queued blocks, added by writers and subtracted by the reader
+    std::atomic<size_t> m_queued;
+    // Oldest node (the last popped message or the stub), only used by the reader
+    alignas(64) Message* m_tail;
+    // True while a reader of this process is attached
+    std::atomic<bool> m_reader;
+    // True while the reader sleeps or is about to
+    std::atomic<bool> m_sleeping;
+    // Number of writers waiting for room
+    std::atomic<size_t> m_waiting;
+    // Guards waiting for room
+    std::mutex m_spaceMutex;
+    // Signals writers waiting for room
+    std::condition_variable m_space;
+    // Wakes the sleeping reader
+    int m_eventFd;
+    // Storage of queued messages, destroyed after them
+    SlabAllocator m_slab;
+
+    /*
+     * \brief Recycle a node no longer referenced by the queue
+     */
+    void release(Message* msg) {
+        if (msg != &m_stub && msg != m_tail) {
+            msg->~Message();
+            m_slab.deallocate(msg);
+        }
+    }
+};
+
+#endif
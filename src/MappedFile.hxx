@@ -0,0 +1,71 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/*
+ * \brief File mapped shared into memory, its content survives a crash of the process
+ */
+class MappedFile {
+public:
+    /*
+     * \brief Open or create the file and map it
+     * \param path Path of the file
+     * \param size Size of the mapping, the file is extended if it is smaller
+     */
+    MappedFile(std::string const& path, size_t size) : m_size(size), m_data(nullptr) {
+        int fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (fd == -1) {
+            perror("open");
+            abort();
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1 || (static_cast<size_t>(st.st_size) < size && ftruncate(fd, size) == -1)) {
+            perror("ftruncate");
+            abort();
+        }
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            abort();
+        }
+        close(fd);
+        m_data = static_cast<char*>(data);
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    ~MappedFile() {
+        munmap(m_data, m_size);
+    }
+
+    /*
+     * \brief Get the mapped memory
+     */
+    char* data() const {
+        return m_data;
+    }
+
+    /*
+     * \brief Get the size of the mapping
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    // Size of the mapping
+    size_t m_size;
+    // Start of the mapping
+    char* m_data;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "BufferPool.hxx"
+
+/*
+ * \brief Action the memory governor applies to the reader using the most memory while the process exceeds its budget
+ */
+enum class MemoryAction {
+    // Only idle receive buffers are shrunk
+    None,
+    // The reader stops reading until usage fell below the resume level, its writers wait for room in the pipe
+    Pause,
+    // The reader drops its partially received frame and continues with a buffer of its base size
+    Drop,
+};
+
+/*
+ * \brief Process-wide memory budget shared by the readers of all pipes
+ *
+ * Every reader accounts its receive buffer and the storage of its in-process queue. Once the
+ * sum exceeds the budget, the buffer pool is emptied, readers without a partial frame are asked
+ * to shrink oversized receive buffers (if enabled) and the configured action is applied to the
+ * reader using the most memory. The requests are carried out by the reader threads, which check
+ * them once per read round, so usage overshoots the budget by at most one buffer growth. Paused
+ * readers resume once usage fell below RESUME_PERCENT of the budget. Pausing relies on other
+ * readers releasing memory, only dropping guarantees progress of a runaway pipe.
+ */
+class MemoryGovernor {
+public:
+    // Usage in percent of the budget below which paused readers resume
+    static constexpr size_t const RESUME_PERCENT = 90;
+    // Requests to a reader, combined in Account::requests()
+    static constexpr uint32_t const SHRINK = 1;
+    static constexpr uint32_t const DROP = 2;
+    static constexpr uint32_t const PAUSE = 4;
+
+    /*
+     * \brief Memory of one reader and the requests of the governor to it
+     */
+    class Account {
+    public:
+        explicit Account(MemoryGovernor& governor) : m_governor(governor), m_buffer(0), m_queue(0), m_bytes(0), m_requests(0) {}
+
+        Account(Account const&) = delete;
+        Account& operator=(Account const&) = delete;
+
+        /*
+         * \brief Account the allocated receive buffer, only called by the reader
+         */
+        void setBuffer(size_t bytes) {
+            if (bytes != m_buffer) {
+                m_buffer = bytes;
+                m_governor.update(*this, m_buffer + m_queue);
+            }
+        }
+
+        /*
+         * \brief Account the storage of the in-process queue, only called by the reader
+         */
+        void setQueue(size_t bytes) {
+            if (bytes != m_queue) {
+                m_queue = bytes;
+                m_governor.update(*this, m_buffer + m_queue);
+            }
+        }
+
+        /*
+         * \brief Get the accounted bytes
+         */
+        size_t bytes() const {
+            return m_bytes.load(std::memory_order_relaxed);
+        }
+
+        /*
+         * \brief Get the pending requests, a combination of SHRINK, DROP and PAUSE
+         */
+        uint32_t requests() const {
+            return m_requests.load(std::memory_order_acquire);
+        }
+
+        /*
+         * \brief Acknowledge carried out SHRINK and DROP requests, only called by the reader
+         */
+        void handled(uint32_t requests) {
+            m_requests.fetch_and(~(requests & (SHRINK | DROP)), std::memory_order_acq_rel);
+        }
+
+    private:
+        friend class MemoryGovernor;
+
+        // Governor the account belongs to
+        MemoryGovernor& m_governor;
+        // Accounted receive buffer and queue, only used by the reader
+        size_t m_buffer;
+        size_t m_queue;
+        // Sum of both, read by the governor
+        std::atomic<size_t> m_bytes;
+        // Pending requests
+        std::atomic<uint32_t> m_requests;
+    };
+
+    /*
+     * \brief Get the governor of the process
+     */
+    static MemoryGovernor& instance() {
+        static MemoryGovernor governor;
+        return governor;
+    }
+
+    /*
+     * \brief Set the budget and the actions applied when it is exceeded
+     * \param budget Bytes all readers may hold together, 0 disables the governor
+     * \param action Action applied to the reader using the most memory
+     * \param shrinkIdle True if readers without a partial frame shrink oversized receive buffers
+     */
+    void configure(size_t budget, MemoryAction action = MemoryAction::Drop, bool shrinkIdle = true) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_action = action;
+            m_shrinkIdle = shrinkIdle;
+            m_budget.store(budget, std::memory_order_relaxed);
+            resumeAll();
+        }
+        // Readers may already hold more than the new budget
+        if (budget > 0 && used() > budget) {
+            relieve();
+        }
+    }
+
+    /*
+     * \brief Get the configured budget, 0 if disabled
+     */
+    size_t budget() const {
+        return m_budget.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Get the bytes currently accounted by all readers
+     */
+    size_t used() const {
+        return m_used.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Get the number of times the budget was exceeded
+     */
+    uint64_t pressureEvents() const {
+        return m_pressureEvents.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Get the number of readers paused so far
+     */
+    uint64_t pauses() const {
+        return m_pauses.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Get the number of readers asked to drop their partial frame so far
+     */
+    uint64_t drops() const {
+        return m_drops.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Create the account of a reader
+     */
+    std::shared_ptr<Account> attach() {
+        std::shared_ptr<Account> account = std::make_shared<Account>(*this);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_accounts.push_back(account);
+        return account;
+    }
+
+    /*
+     * \brief Remove the account of a reader whose reader stopped, its memory is no longer accounted
+     */
+    void detach(std::shared_ptr<Account> const& account) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_accounts.erase(std::remove(m_accounts.begin(), m_accounts.end(), account), m_accounts.end());
+            if ((account->m_requests.exchange(0, std::memory_order_acq_rel) & PAUSE) != 0) {
+                --m_paused;
+            }
+        }
+        account->m_buffer = 0;
+        account->m_queue = 0;
+        update(*account, 0);
+    }
+
+private:
+    // Budget in bytes, 0 if disabled
+    std::atomic<size_t> m_budget;
+    // Bytes accounted by all readers
+    std::atomic<size_t> m_used;
+    // Number of paused readers, guarded by m_mutex
+    size_t m_paused;
+    // Action applied to the largest reader, guarded by m_mutex
+    MemoryAction m_action;
+    // Shrink oversized buffers of idle readers, guarded by m_mutex
+    bool m_shrinkIdle;
+    // Counters of pressure events and applied actions
+    std::atomic<uint64_t> m_pressureEvents;
+    std::atomic<uint64_t> m_pauses;
+    std::atomic<uint64_t> m_drops;
+    // Guards the accounts and the configuration
+    std::mutex m_mutex;
+    // Accounts of all readers
+    std::vector<std::shared_ptr<Account>> m_accounts;
+
+    MemoryGovernor() : m_budget(0), m_used(0), m_paused(0), m_action(MemoryAction::Drop), m_shrinkIdle(true), m_pressureEvents(0),
+          m_pauses(0), m_drops(0) {}
+
+    /*
+     * \brief Change the bytes of an account, relieves pressure if the budget is exceeded
+     */
+    void update(Account& account, size_t bytes) {
+        size_t old = account.m_bytes.exchange(bytes, std::memory_order_relaxed);
+        size_t budget = m_budget.load(std::memory_order_relaxed);
+        if (bytes >= old) {
+            size_t used = m_used.fetch_add(bytes - old, std::memory_order_relaxed) + (bytes - old);
+            if (budget > 0 && used > budget) {
+                relieve();
+            }
+        } else {
+            size_t used = m_used.fetch_sub(old - bytes, std::memory_order_relaxed) - (old - bytes);
+            if (budget > 0 && used <= budget / 100 * RESUME_PERCENT) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                resumeAll();
+            }
+        }
+    }
+
+    /*
+     * \brief Ask readers to release memory, skipped if another thread already does
+     */
+    void relieve() {
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        m_pressureEvents.fetch_add(1, std::memory_order_relaxed);
+        // Pooled buffers are not in use by any reader
+        BufferPool::instance().trim();
+        Account* largest = nullptr;
+        for (std::shared_ptr<Account> const& account : m_accounts) {
+            if (m_shrinkIdle) {
+                account->m_requests.fetch_or(SHRINK, std::memory_order_acq_rel);
+            }
+            if (largest == nullptr || account->bytes() > largest->bytes()) {
+                largest = account.get();
+            }
+        }
+        if (largest == nullptr) {
+            return;
+        }
+        if (m_action == MemoryAction::Pause && (largest->m_requests.fetch_or(PAUSE, std::memory_order_acq_rel) & PAUSE) == 0) {
+            ++m_paused;
+            m_pauses.fetch_add(1, std::memory_order_relaxed);
+        } else if (m_action == MemoryAction::Drop && (largest->m_requests.fetch_or(DROP, std::memory_order_acq_rel) & DROP) == 0) {
+            m_drops.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * \brief Resume all paused readers, m_mutex has to be held
+     */
+    void resumeAll() {
+        if (m_paused == 0) {
+            return;
+        }
+        for (std::shared_ptr<Account> const& account : m_accounts) {
+            account->m_requests.fetch_and(~PAUSE, std::memory_order_acq_rel);
+        }
+        m_paused = 0;
+    }
+};
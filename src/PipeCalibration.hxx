@@ -0,0 +1,196 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+#include "UnixPipe.hxx"
+
+/*
+ * \brief Measures the named pipe characteristics of this host and derives a PipeConfig
+ *
+ * Each parameter is tuned in turn while keeping the best values found so far:
+ * kernel capacity, read size and coalescing threshold are chosen by throughput
+ * across all message sizes, the spin budget by the one-way latency of paced messages.
+ */
+class PipeCalibration {
+public:
+    /*
+     * \brief Create calibration
+     * \param log Stream receiving the measurements
+     */
+    explicit PipeCalibration(std::ostream& log) : m_log(log), m_name("/tmp/pipe-cxx-calibrate-" + std::to_string(getpid())) {}
+
+    /*
+     * \brief Run all measurements and return the recommended configuration
+     */
+    PipeConfig run() {
+        PipeConfig best;
+        best.capacity = choose("capacity", best, &PipeConfig::capacity, capacities());
+        best.readSize = choose("read_size", best, &PipeConfig::readSize, { 4096, 8096, 16384, 65536 });
+        // Coalescing holds back messages until the threshold is reached, so only use it if it pays off clearly
+        PipeConfig candidate = best;
+        candidate.coalesceThreshold = choose("coalesce_threshold", best, &PipeConfig::coalesceThreshold, { 0, 4096, 16384, 65536 });
+        if (candidate.coalesceThreshold > 0 && throughput(candidate) < 1.2 * throughput(best)) {
+            candidate.coalesceThreshold = 0;
+        }
+        best = candidate;
+        best.spinBudget = chooseSpinBudget(best);
+        unlink(m_name.c_str());
+        return best;
+    }
+
+private:
+    // Message sizes used for throughput measurements
+    static constexpr size_t const MESSAGE_SIZES[] = { 64, 512, 4096 };
+    // Total payload bytes transferred per throughput measurement
+    static size_t const BYTES_PER_RUN = 8 << 20;
+    // Number of paced messages per latency measurement
+    static size_t const LATENCY_MESSAGES = 2000;
+
+    // Stream receiving the measurements
+    std::ostream& m_log;
+    // Path of the named pipe used for measurements
+    std::string m_name;
+
+    /*
+     * \brief Current monotonic time in nanoseconds
+     */
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /*
+     * \brief Candidate kernel capacities, limited by /proc/sys/fs/pipe-max-size
+     */
+    static std::vector<size_t> capacities() {
+        size_t max = 1 << 20;
+        std::ifstream file("/proc/sys/fs/pipe-max-size");
+        file >> max;
+        std::vector<size_t> result;
+        for (size_t capacity : { 1 << 16, 1 << 18, 1 << 20 }) {
+            if (capacity <= max) {
+                result.push_back(capacity);
+            }
+        }
+        return result;
+    }
+
+    /*
+     * \brief Pick the candidate value of a parameter with the highest throughput
+     * \param name Name of the parameter for logging
+     * \param base Configuration used for all other parameters
+     * \param field Parameter to vary
+     * \param candidates Candidate values
+     */
+    size_t choose(std::string const& name, PipeConfig const& base, size_t PipeConfig::* field, std::vector<size_t> const& candidates) {
+        size_t bestValue = base.*field;
+        double bestRate = 0;
+        for (size_t value : candidates) {
+            PipeConfig config = base;
+            config.*field = value;
+            double rate = throughput(config);
+            m_log << name << "=" << value << ": " << rate / 1e6 << " MB/s" << std::endl;
+            if (rate > bestRate) {
+                bestRate = rate;
+                bestValue = value;
+            }
+        }
+        return bestValue;
+    }
+
+    /*
+     * \brief Geometric mean of the payload throughput in bytes per second across all message sizes
+     * \param config Configuration to measure
+     */
+    double throughput(PipeConfig config) {
+        // Measure the named pipe, not the in-process queue
+        config.localShortcut = false;
+        double logSum = 0;
+        for (size_t size : MESSAGE_SIZES) {
+            size_t messages = BYTES_PER_RUN / size;
+            std::atomic<size_t> received(0);
+            uint64_t duration;
+            {
+                UnixPipe writer(m_name, PipeAccess::Write, config);
+                UnixPipe reader(m_name, PipeAccess::Read, config);
+                reader.addCallback("calibrate", [&](std::string const&) {
+                    received.fetch_add(1, std::memory_order_relaxed);
+                });
+                reader.start();
+                std::string payload(size, 'x');
+                uint64_t start = now();
+                for (size_t idx = 0; idx < messages; ++idx) {
+                    writer.write("calibrate", payload);
+                }
+                writer.flush();
+                while (received.load(std::memory_order_relaxed) < messages) {
+                    std::this_thread::yield();
+                }
+                duration = now() - start;
+            }
+            logSum += std::log(static_cast<double>(BYTES_PER_RUN) * 1e9 / duration);
+        }
+        return std::exp(logSum / (sizeof(MESSAGE_SIZES) / sizeof(MESSAGE_SIZES[0])));
+    }
+
+    /*
+     * \brief Median one-way latency of paced messages in nanoseconds
+     * \param config Configuration to measure
+     */
+    uint64_t latency(PipeConfig const& config) {
+        std::vector<uint64_t> samples;
+        samples.reserve(LATENCY_MESSAGES);
+        std::atomic<size_t> received(0);
+        {
+            PipeConfig unbatched = config;
+            unbatched.coalesceThreshold = 0;
+            unbatched.localShortcut = false;
+            UnixPipe writer(m_name, PipeAccess::Write, unbatched);
+            UnixPipe reader(m_name, PipeAccess::Read, unbatched);
+            reader.addCallback("calibrate", [&](std::string const& msg) {
+                samples.push_back(now() - std::stoull(msg));
+                received.fetch_add(1, std::memory_order_release);
+            });
+            reader.start();
+            for (size_t idx = 0; idx < LATENCY_MESSAGES; ++idx) {
+                writer.write("calibrate", std::to_string(now()));
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            while (received.load(std::memory_order_acquire) < LATENCY_MESSAGES) {
+                std::this_thread::yield();
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    /*
+     * \brief Pick the smallest spin budget whose latency is close to the best one, spinning burns CPU
+     * \param base Configuration used for all other parameters
+     */
+    size_t chooseSpinBudget(PipeConfig const& base) {
+        std::vector<std::pair<size_t, uint64_t>> results;
+        uint64_t best = UINT64_MAX;
+        for (size_t spinBudget : { 0, 100, 1000, 10000 }) {
+            PipeConfig config = base;
+            config.spinBudget = spinBudget;
+            uint64_t median = latency(config);
+            m_log << "spin_budget=" << spinBudget << ": p50 " << median / 1e3 << " us" << std::endl;
+            results.emplace_back(spinBudget, median);
+            best = std::min(best, median);
+        }
+        for (auto const& result : results) {
+            if (result.second <= best * 1.1) {
+                return result.first;
+            }
+        }
+        return 0;
+    }
+};
+
+#endif
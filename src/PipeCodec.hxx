@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+
+/*
+ * \brief Frame format of UnixPipe
+ *
+ * A frame is PREFIX:START:<id length>:<content length>:<id>:<content>:END: with every tag in
+ * identifier and content escaped by a preceding backslash. All functions run in time linear
+ * in their input, whatever bytes they are given: the parser never scans a byte twice across
+ * calls on a growing buffer (apart from the constant size header of an incomplete frame) and
+ * resynchronizes on the next frame start after corrupt data instead of waiting forever.
+ */
+class PipeCodec {
+public:
+    // Prefix attached to each message to check for start
+    constexpr static const char* const PREFIX = "NAMEDPIPE";
+    constexpr static const char* const START = "START";
+    constexpr static const char* const END = "END";
+    // Maximum number of digits of a length field, longer fields are corrupt
+    static constexpr size_t const MAX_LENGTH_DIGITS = 19;
+    // Upper bound of header and trailer of a frame besides identifier and content
+    static constexpr size_t const FRAME_OVERHEAD = 64;
+
+    /*
+     * \brief Result of parsing the start of a buffer
+     */
+    struct Message {
+        // Identifier of the message, unescaped, pointing into the input buffer or the identifier storage passed to next()
+        std::string_view id;
+        // Message content, still escaped and pointing into the input buffer
+        std::string_view content;
+        // Number of bytes consumed from the start of the buffer, 0 if more data is needed
+        size_t totalLength;
+        // False if the consumed bytes do not form a message (corrupt data or data before a frame) and are dropped
+        bool valid;
+    };
+
+    /*
+     * \brief Create the frame of a message
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     */
+    static std::string frame(std::string_view id, std::string_view msg) {
+        std::string escapedId = escape(id);
+        std::string out;
+        out.reserve(escapedId.size() + msg.size() + FRAME_OVERHEAD);
+        if (!containsTag(msg)) {
+            appendHeader(out, escapedId, msg.size());
+            out.append(msg);
+        } else {
+            std::string escapedMsg = escape(msg);
+            appendHeader(out, escapedId, escapedMsg.size());
+            out += escapedMsg;
+        }
+        appendTrailer(out);
+        return out;
+    }
+
+    /*
+     * \brief Append frame header up to the start of the content
+     * \param out Frame buffer
+     * \param escapedId Escaped message identifier
+     * \param contentLength Length of the escaped content
+     */
+    static void appendHeader(std::string& out, std::string_view escapedId, size_t contentLength) {
+        out.append(PREFIX).append(":").append(START).append(":").append(std::to_string(escapedId.size())).append(":")
+            .append(std::to_string(contentLength)).append(":").append(escapedId).append(":");
+    }
+
+    /*
+     * \brief Append frame trailer behind the content
+     */
+    static void appendTrailer(std::string& out) {
+        out.append(":").append(END).append(":");
+    }
+
+    /*
+     * \brief Check if a string contains a tag and has to be escaped
+     */
+    static bool containsTag(std::string_view str) {
+        return str.find(PREFIX) != std::string_view::npos || str.find(START) != std::string_view::npos || str.find(END) != std::string_view::npos;
+    }
+
+    /*
+     * \brief Check if a received content may contain escaped tags and has to be unescaped
+     */
+    static bool escaped(std::string_view content) {
+        return content.find('\\') != std::string_view::npos;
+    }
+
+    /*
+     * \brief Escape all tags in a single pass
+     * \param str Input string
+     */
+    static std::string escape(std::string_view str) {
+        static const char* const tags[] = { PREFIX, START, END };
+        // Next occurrence of each tag, every search continues behind the previous one
+        size_t next[3];
+        for (size_t idx = 0; idx < 3; ++idx) {
+            next[idx] = str.find(tags[idx]);
+        }
+        std::string out;
+        out.reserve(*std::min_element(next, next + 3) == std::string_view::npos ? str.size() : str.size() + 16);
+        size_t start = 0;
+        while (true) {
+            // Tags start with different characters, so occurrences never coincide
+            size_t first = std::min_element(next, next + 3) - next;
+            size_t pos = next[first];
+            if (pos == std::string_view::npos) {
+                break;
+            }
+            size_t length = std::strlen(tags[first]);
+            out.append(str.substr(start, pos - start)).append("\\").append(str.substr(pos, length));
+            start = pos + length;
+            // Tags overlapping the escaped one stay unescaped like in unescape()
+            for (size_t idx = 0; idx < 3; ++idx) {
+                if (next[idx] < start) {
+                    next[idx] = str.find(tags[idx], start);
+                }
+            }
+        }
+        out.append(str.substr(start));
+        return out;
+    }
+
+    /*
+     * \brief Revert escape() in a single pass
+     * \param str Escaped string
+     */
+    static std::string unescape(std::string_view str) {
+        std::string out;
+        unescapeTo(str, out);
+        return out;
+    }
+
+    /*
+     * \brief Revert escape() into a reused string, which only allocates if its capacity is too small
+     * \param str Escaped string
+     * \param out Replaced by the unescaped string
+     */
+    static void unescapeTo(std::string_view str, std::string& out) {
+        out.clear();
+        size_t start = 0;
+        size_t pos = 0;
+        while ((pos = str.find('\\', pos)) != std::string_view::npos) {
+            size_t length = tagAt(str, pos + 1);
+            if (length == 0) {
+                ++pos;
+                continue;
+            }
+            // Drop the backslash, the tag is copied with the following part
+            out.append(str.substr(start, pos - start));
+            start = pos + 1;
+            pos += 1 + length;
+        }
+        out.append(str.substr(start));
+    }
+
+    /*
+     * \brief Parse the frame at the start of a buffer
+     *
+     * Data before the first unescaped frame start and frames with malformed header or trailer
+     * are returned as invalid message to be dropped, so the caller always makes progress.
+     * \param input Received data
+     * \param idStorage Holds the identifier if it has to be unescaped
+     * \param unescapeId False if identifiers are not escaped, see RawCodec
+     */
+    static Message next(std::string_view input, std::string& idStorage, bool unescapeId = true) {
+        static std::string const prefix = std::string(PREFIX) + ":" + std::string(START) + ":";
+        static size_t const endLength = std::strlen(END);
+        Message msg;
+        msg.totalLength = 0;
+        msg.valid = false;
+        // Find the first frame start that is not escaped
+        size_t posPrefix = 0;
+        while (true) {
+            posPrefix = input.find(prefix, posPrefix);
+            if (posPrefix == std::string_view::npos) {
+                // Keep only what may be the beginning of a frame start (including an escaping backslash)
+                msg.totalLength = input.size() > prefix.size() ? input.size() - prefix.size() : 0;
+                return msg;
+            } else if (posPrefix == 0 || input[posPrefix - 1] != '\\') {
+                break;
+            }
+            ++posPrefix;
+        }
+        // Drop data before the frame
+        if (posPrefix > 0) {
+            msg.totalLength = posPrefix;
+            return msg;
+        }
+        // Parse both lengths
+        size_t idLen;
+        size_t msgLen;
+        size_t posEndIdLen;
+        size_t posEndMsgLen;
+        Field field = parseLength(input, prefix.size(), idLen, posEndIdLen);
+        if (field == Field::Complete) {
+            field = parseLength(input, posEndIdLen + 1, msgLen, posEndMsgLen);
+        }
+        if (field == Field::Incomplete) {
+            return msg;
+        } else if (field == Field::Corrupt) {
+            msg.totalLength = prefix.size();
+            return msg;
+        }
+        // Check if total length is enough
+        size_t posId = posEndMsgLen + 1;
+        size_t posContent = posId + idLen + 1;
+        size_t totalLength = posContent + msgLen + endLength + 2;
+        if (input.size() < totalLength) {
+            return msg;
+        }
+        if (input[posContent - 1] != ':' || input[posContent + msgLen] != ':' || input.compare(posContent + msgLen + 1, endLength, END) != 0
+                || input[totalLength - 1] != ':') {
+            msg.totalLength = prefix.size();
+            return msg;
+        }
+        // Extract id and message
+        msg.totalLength = totalLength;
+        msg.valid = true;
+        msg.id = input.substr(posId, idLen);
+        if (unescapeId && msg.id.find('\\') != std::string_view::npos) {
+            unescapeTo(msg.id, idStorage);
+            msg.id = idStorage;
+        }
+        msg.content = input.substr(posContent, msgLen);
+        return msg;
+    }
+
+private:
+    /*
+     * \brief Parse state of a length field
+     */
+    enum class Field {
+        Complete,
+        Incomplete,
+        Corrupt,
+    };
+
+    /*
+     * \brief Length of the tag starting at the given position, 0 if none
+     */
+    static size_t tagAt(std::string_view str, size_t pos) {
+        for (const char* tag : { PREFIX, START, END }) {
+            size_t length = std::strlen(tag);
+            if (str.size() >= pos + length && str.compare(pos, length, tag) == 0) {
+                return length;
+            }
+        }
+        return 0;
+    }
+
+    /*
+     * \brief Parse a decimal length field terminated by a separator
+     * \param input Received data
+     * \param start Position of the first digit
+     * \param value Parsed length
+     * \param end Position of the separator
+     */
+    static Field parseLength(std::string_view input, size_t start, size_t& value, size_t& end) {
+        end = start;
+        while (end < input.size() && end - start <= MAX_LENGTH_DIGITS && input[end] >= '0' && input[end] <= '9') {
+            ++end;
+        }
+        if (end - start > MAX_LENGTH_DIGITS) {
+            return Field::Corrupt;
+        } else if (end == input.size()) {
+            return Field::Incomplete;
+        } else if (end == start || input[end] != ':') {
+            return Field::Corrupt;
+        }
+        std::from_chars(input.data() + start, input.data() + end, value);
+        // Lengths beyond what fits into memory would overflow the frame length
+        return value > std::numeric_limits<size_t>::max() / 4 ? Field::Corrupt : Field::Complete;
+    }
+};
+
+/*
+ * \brief Frame format without escaping, for pipes whose writers never send tags or are trusted
+ *
+ * Frames look like PipeCodec frames, but tags in identifier and content are sent as they are
+ * and only the lengths of the header delimit them. Neither side scans contents for tags, but
+ * after corrupt data the parser may resynchronize on a tag inside a content. Writers and
+ * reader of a pipe have to use the same codec.
+ */
+class RawCodec : public PipeCodec {
+public:
+    static std::string frame(std::string_view id, std::string_view msg) {
+        std::string out;
+        out.reserve(id.size() + msg.size() + 64);
+        appendHeader(out, id, msg.size());
+        out.append(msg);
+        appendTrailer(out);
+        return out;
+    }
+
+    static bool containsTag(std::string_view) {
+        return false;
+    }
+
+    static bool escaped(std::string_view) {
+        return false;
+    }
+
+    static std::string escape(std::string_view str) {
+        return std::string(str);
+    }
+
+    static std::string unescape(std::string_view str) {
+        return std::string(str);
+    }
+
+    static void unescapeTo(std::string_view str, std::string& out) {
+        out.assign(str.data(), str.size());
+    }
+
+    static Message next(std::string_view input, std::string& idStorage) {
+        return PipeCodec::next(input, idStorage, false);
+    }
+};
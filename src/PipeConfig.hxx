@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/*
+ * \brief Byte stream carrying the frames of a pipe
+ */
+enum class TransportType {
+    // Named pipe in the file system
+    Fifo,
+    // Byte queue in memory, only between pipes of the same process, e.g. to measure framing and dispatch
+    Memory,
+    // Unix SOCK_SEQPACKET socket, every frame up to PIPE_BUF bytes is one packet and the reader fetches packets in batches
+    SeqPacket,
+};
+
+/*
+ * \brief Tuning parameters of a UnixPipe, usually produced by `pipe-cxx calibrate`
+ */
+struct PipeConfig {
+    // Name of the environment variable pointing to a configuration file loaded at startup
+    constexpr static const char* const ENVIRONMENT = "PIPE_CXX_CONFIG";
+
+    // Kernel pipe capacity set via F_SETPIPE_SZ, 0 keeps the system default
+    size_t capacity = 0;
+    // Initial (and incremental) size of the receive buffer, i.e. the amount of data fetched per read
+    size_t readSize = 8096;
+    // Frames are collected until this many bytes are pending before writing them, 0 writes immediately
+    size_t coalesceThreshold = 0;
+    // Number of non-blocking read attempts of the reader before it sleeps in poll
+    size_t spinBudget = 0;
+    // Latency mode: receive and send buffers are pre-sized to this many bytes and pre-faulted, 0 disables it
+    size_t prefaultSize = 0;
+    // Lock the pre-faulted buffers and the reader stack into memory via mlock
+    bool lockMemory = false;
+    // Pass messages in memory instead of through the named pipe if writer and reader live in the same process
+    bool localShortcut = true;
+    // Readers served by a PipeReactor hand their receive buffer back to the BufferPool after this many idle milliseconds, 0 disables it
+    size_t hibernateAfterMs = 1000;
+    // Bytes a reader served by a PipeReactor may read per turn before the other ready pipes get theirs
+    size_t reactorQuantumBytes = 65536;
+    // Messages a reader served by a PipeReactor may dispatch per turn, 0 only limits bytes
+    size_t reactorQuantumMessages = 0;
+    // Number of quanta a reader served by a PipeReactor gets per turn
+    size_t reactorWeight = 1;
+    // Transport of the frames, a named pipe by default
+    TransportType transport = TransportType::Fifo;
+
+    /*
+     * \brief Load configuration from a file, missing keys keep their default value
+     * \param path Path of the configuration file
+     */
+    static PipeConfig load(std::string const& path) {
+        PipeConfig config;
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Unable to open pipe configuration " << path << "." << std::endl;
+            return config;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            // Skip comments and empty lines
+            size_t posSep = line.find('=');
+            if (line.empty() || line[0] == '#' || posSep == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(0, posSep);
+            size_t value = std::strtoull(line.c_str() + posSep + 1, nullptr, 10);
+            if (key == "capacity") {
+                config.capacity = value;
+            } else if (key == "read_size" && value > 0) {
+                config.readSize = value;
+            } else if (key == "coalesce_threshold") {
+                config.coalesceThreshold = value;
+            } else if (key == "spin_budget") {
+                config.spinBudget = value;
+            } else if (key == "prefault_size") {
+                config.prefaultSize = value;
+            } else if (key == "lock_memory") {
+                config.lockMemory = value != 0;
+            } else if (key == "local_shortcut") {
+                config.localShortcut = value != 0;
+            } else if (key == "hibernate_after_ms") {
+                config.hibernateAfterMs = value;
+            } else if (key == "reactor_quantum_bytes" && value > 0) {
+                config.reactorQuantumBytes = value;
+            } else if (key == "reactor_quantum_messages") {
+                config.reactorQuantumMessages = value;
+            } else if (key == "reactor_weight" && value > 0) {
+                config.reactorWeight = value;
+            } else if (key == "transport") {
+                std::string name = line.substr(posSep + 1);
+                config.transport = name == "memory" ? TransportType::Memory : name == "seqpacket" ? TransportType::SeqPacket : TransportType::Fifo;
+            } else {
+                std::cerr << "Unknown pipe configuration key " << key << "." << std::endl;
+            }
+        }
+        return config;
+    }
+
+    /*
+     * \brief Load configuration from the file named by PIPE_CXX_CONFIG, defaults if unset
+     */
+    static PipeConfig fromEnvironment() {
+        const char* path = std::getenv(ENVIRONMENT);
+        return (path != nullptr && path[0] != '\0') ? load(path) : PipeConfig();
+    }
+
+    /*
+     * \brief Serialize configuration in the format understood by load()
+     */
+    std::string toString() const {
+        std::ostringstream out;
+        out << "capacity=" << capacity << "\n"
+            << "read_size=" << readSize << "\n"
+            << "coalesce_threshold=" << coalesceThreshold << "\n"
+            << "spin_budget=" << spinBudget << "\n"
+            << "prefault_size=" << prefaultSize << "\n"
+            << "lock_memory=" << (lockMemory ? 1 : 0) << "\n"
+            << "local_shortcut=" << (localShortcut ? 1 : 0) << "\n"
+            << "hibernate_after_ms=" << hibernateAfterMs << "\n"
+            << "reactor_quantum_bytes=" << reactorQuantumBytes << "\n"
+            << "reactor_quantum_messages=" << reactorQuantumMessages << "\n"
+            << "reactor_weight=" << reactorWeight << "\n"
+            << "transport=" << (transport == TransportType::Memory ? "memory" : transport == TransportType::SeqPacket ? "seqpacket" : "fifo") << "\n";
+        return out.str();
+    }
+};
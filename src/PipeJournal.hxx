@@ -0,0 +1,243 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "MappedFile.hxx"
+
+/*
+ * \brief Bounded journal of sent but not yet acknowledged messages in a memory mapped file
+ *
+ * The messages are stored in a ring of records [sequence][id length][message length][id][message]
+ * behind a header holding the sequence numbers and the ring position of the oldest record.
+ * Sequence numbers start at 1 and are contiguous, so the unacknowledged records are exactly
+ * the sequences after the acknowledged one. The journal is not synchronized, a single
+ * process may use it at a time.
+ */
+class PipeJournal {
+public:
+    // Identifies an initialized journal file
+    static constexpr uint64_t const MAGIC = 0x4c4e524a45504950;
+
+    /*
+     * \brief Open the journal, unacknowledged records of a previous process are recovered
+     * \param path Path of the journal file
+     * \param capacity Number of bytes available for records
+     */
+    PipeJournal(std::string const& path, size_t capacity) : m_file(path, sizeof(Header) + capacity), m_capacity(capacity) {
+        if (header().magic != MAGIC || header().capacity != capacity) {
+            header() = Header{ MAGIC, capacity, 1, 0, 0, 0 };
+        }
+        // The write position is derived from the records, it may be stale after a crash during append()
+        m_head = header().tail;
+        for (uint64_t sequence = header().acknowledged + 1; sequence < header().next; ++sequence) {
+            m_head = advance(position(m_head));
+        }
+    }
+
+    /*
+     * \brief Check if a message fits into the free space
+     * \param idLength Length of the message identifier
+     * \param msgLength Length of the message
+     */
+    bool fits(size_t idLength, size_t msgLength) const {
+        size_t length = recordLength(idLength, msgLength);
+        if (length > m_capacity) {
+            throw std::logic_error("Message is larger than the journal capacity.");
+        }
+        return place(length) != SIZE_MAX;
+    }
+
+    /*
+     * \brief Append a message, has to fit
+     * \param id Message identifier
+     * \param msg Message
+     * \return Sequence number assigned to the message
+     */
+    uint64_t append(std::string_view id, std::string_view msg) {
+        size_t length = recordLength(id.size(), msg.size());
+        size_t offset = place(length);
+        if (offset == SIZE_MAX) {
+            throw std::logic_error("Journal is full.");
+        }
+        // Mark skipped end of the ring
+        if (offset == 0 && m_head != 0 && m_capacity - m_head >= sizeof(Record)) {
+            std::memset(data(m_head), 0, sizeof(Record));
+        }
+        uint64_t sequence = header().next;
+        Record record = { sequence, static_cast<uint32_t>(id.size()), static_cast<uint32_t>(msg.size()) };
+        std::memcpy(data(offset), &record, sizeof(Record));
+        std::memcpy(data(offset) + sizeof(Record), id.data(), id.size());
+        std::memcpy(data(offset) + sizeof(Record) + id.size(), msg.data(), msg.size());
+        m_head = offset + length;
+        // Publish the record last, a crash before leaves it unacknowledged and invisible
+        header().next = sequence + 1;
+        return sequence;
+    }
+
+    /*
+     * \brief Release all records up to and including the given sequence
+     * \param sequence Last acknowledged sequence number
+     */
+    void acknowledge(uint64_t sequence) {
+        sequence = std::min(sequence, header().next - 1);
+        size_t tail = header().tail;
+        for (uint64_t current = header().acknowledged + 1; current <= sequence; ++current) {
+            tail = advance(position(tail));
+        }
+        if (sequence > header().acknowledged) {
+            header().tail = tail;
+            header().acknowledged = sequence;
+        }
+        // Restart at the beginning if empty to keep records contiguous
+        if (pending() == 0) {
+            header().tail = 0;
+            m_head = 0;
+        }
+    }
+
+    /*
+     * \brief Continue with the given sequence number, all earlier records are released
+     * \param sequence Next sequence number to assign
+     */
+    void skipTo(uint64_t sequence) {
+        if (sequence > header().next) {
+            acknowledge(header().next - 1);
+            header().next = sequence;
+            header().acknowledged = sequence - 1;
+        }
+    }
+
+    /*
+     * \brief Call the given callable for each unacknowledged record in sequence order
+     * \param callback Callable taking sequence number, message identifier and message
+     */
+    template<typename F>
+    void forEach(F&& callback) const {
+        size_t offset = header().tail;
+        for (uint64_t sequence = header().acknowledged + 1; sequence < header().next; ++sequence) {
+            offset = position(offset);
+            Record record;
+            std::memcpy(&record, data(offset), sizeof(Record));
+            char const* id = data(offset) + sizeof(Record);
+            callback(record.sequence, std::string_view(id, record.idLength), std::string_view(id + record.idLength, record.msgLength));
+            offset = advance(offset);
+        }
+    }
+
+    /*
+     * \brief Get the number of unacknowledged records
+     */
+    uint64_t pending() const {
+        return header().next - 1 - header().acknowledged;
+    }
+
+    /*
+     * \brief Get the sequence number assigned to the next record
+     */
+    uint64_t nextSequence() const {
+        return header().next;
+    }
+
+    /*
+     * \brief Get the last acknowledged sequence number
+     */
+    uint64_t acknowledgedSequence() const {
+        return header().acknowledged;
+    }
+
+private:
+    /*
+     * \brief Journal state at the start of the file
+     */
+    struct Header {
+        uint64_t magic;
+        uint64_t capacity;
+        // Sequence number of the next record
+        uint64_t next;
+        // Last acknowledged sequence number
+        uint64_t acknowledged;
+        // Ring offset of the oldest unacknowledged record
+        uint64_t tail;
+        uint64_t reserved;
+    };
+
+    /*
+     * \brief Header of a record, a zero sequence marks the skipped end of the ring
+     */
+    struct Record {
+        uint64_t sequence;
+        uint32_t idLength;
+        uint32_t msgLength;
+    };
+
+    // Mapped journal file
+    MappedFile m_file;
+    // Number of bytes available for records
+    size_t m_capacity;
+    // Ring offset behind the newest record
+    size_t m_head;
+
+    Header& header() const {
+        return *reinterpret_cast<Header*>(m_file.data());
+    }
+
+    char* data(size_t offset) const {
+        return m_file.data() + sizeof(Header) + offset;
+    }
+
+    static size_t recordLength(size_t idLength, size_t msgLength) {
+        // Keep records 8 byte aligned
+        return (sizeof(Record) + idLength + msgLength + 7) & ~size_t(7);
+    }
+
+    /*
+     * \brief Resolve the offset of a record, following the wrap to the start of the ring
+     */
+    size_t position(size_t offset) const {
+        if (m_capacity - offset < sizeof(Record)) {
+            return 0;
+        }
+        Record record;
+        std::memcpy(&record, data(offset), sizeof(Record));
+        return record.sequence == 0 ? 0 : offset;
+    }
+
+    /*
+     * \brief Offset behind the record at the given (resolved) offset
+     */
+    size_t advance(size_t offset) const {
+        Record record;
+        std::memcpy(&record, data(offset), sizeof(Record));
+        return offset + recordLength(record.idLength, record.msgLength);
+    }
+
+    /*
+     * \brief Find the offset for a new record of the given length
+     * \return Offset or SIZE_MAX if there is not enough free space
+     */
+    size_t place(size_t length) const {
+        size_t tail = header().tail;
+        if (pending() == 0) {
+            return length <= m_capacity ? 0 : SIZE_MAX;
+        } else if (m_head > tail) {
+            // Free space at the end, otherwise wrap around in front of the tail
+            if (m_capacity - m_head >= length) {
+                return m_head;
+            }
+            return length <= tail ? 0 : SIZE_MAX;
+        } else if (m_head < tail) {
+            return tail - m_head >= length ? m_head : SIZE_MAX;
+        }
+        // Head reached tail, the ring is full
+        return SIZE_MAX;
+    }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+
+#include "FrameSizeHistogram.hxx"
+#include "IdStatistics.hxx"
+
+/*
+ * Policies of BasicUnixPipe besides the framing, which is selected by a codec (PipeCodec or
+ * RawCodec). Each feature has a default policy with the full behavior and one that compiles
+ * it out of the hot paths, so a deployment only pays for what it uses.
+ */
+
+/*
+ * \brief Buffer policy adapting the receive buffer to a running histogram of frame sizes, FixedBuffer switches it off
+ */
+class AdaptiveBuffer {
+public:
+    // Bounds of the adapted receive buffer size
+    static constexpr size_t const MIN_BUFFER_SIZE = 1024;
+    static constexpr size_t const MAX_BUFFER_SIZE = 8 * 1024 * 1024;
+    // Number of median frames an adapted receive buffer holds so a read fetches a batch, up to READ_BATCH_LIMIT bytes
+    static constexpr size_t const FRAMES_PER_READ = 32;
+    static constexpr size_t const READ_BATCH_LIMIT = 64 * 1024;
+    // Number of received frames between adaptations of the receive buffer size
+    static constexpr size_t const ADAPT_INTERVAL = 256;
+
+    AdaptiveBuffer() : m_sinceAdapt(0) {}
+
+    /*
+     * \brief Record the size of a received frame
+     */
+    void record(size_t bytes) {
+        if (!m_frameSizes) {
+            m_frameSizes.reset(new FrameSizeHistogram());
+        }
+        m_frameSizes->record(bytes);
+        ++m_sinceAdapt;
+    }
+
+    /*
+     * \brief Forget the frame sizes of a hibernating pipe, the adapted sizes stay with the pipe
+     */
+    void release() {
+        m_frameSizes.reset();
+        m_sinceAdapt = 0;
+    }
+
+    /*
+     * \brief Check if enough frames were received since the last adaptation
+     */
+    bool due() const {
+        return m_sinceAdapt >= ADAPT_INTERVAL;
+    }
+
+    /*
+     * \brief Adapt base size and growth step of the receive buffer to the observed frame sizes
+     *
+     * Pipes of small frames keep a small, cache resident buffer that still holds a batch of
+     * frames, pipes of large frames get a buffer that holds nearly all of them without growing.
+     * \param minimum Size the transport needs to read efficiently
+     * \param baseSize Size of a new receive buffer
+     * \param growStep Growth of the receive buffer if a frame does not fit
+     */
+    void adapt(size_t minimum, size_t& baseSize, size_t& growStep) {
+        m_sinceAdapt = 0;
+        size_t median = m_frameSizes->percentile(50);
+        size_t large = m_frameSizes->percentile(99);
+        baseSize = std::min(MAX_BUFFER_SIZE, std::max({ MIN_BUFFER_SIZE, std::min(median * FRAMES_PER_READ, READ_BATCH_LIMIT), large, minimum }));
+        growStep = std::min(MAX_BUFFER_SIZE, std::max(MIN_BUFFER_SIZE, large));
+    }
+
+private:
+    // Sizes of received frames, nullptr until the first frame and while the pipe hibernates
+    std::unique_ptr<FrameSizeHistogram> m_frameSizes;
+    // Frames received since the last adaptation
+    size_t m_sinceAdapt;
+};
+
+/*
+ * \brief Buffer policy growing the receive buffer in steps of PipeConfig::readSize, without frame size histogram
+ */
+class FixedBuffer {
+public:
+    void record(size_t) {}
+
+    void release() {}
+
+    bool due() const {
+        return false;
+    }
+
+    void adapt(size_t, size_t&, size_t&) {}
+};
+
+/*
+ * \brief Locking policy serializing writers of any thread with a mutex
+ */
+struct MutexLocking {
+    // Writes of background threads are serialized with the writers
+    static constexpr bool const CONCURRENT = true;
+    using Mutex = std::mutex;
+};
+
+/*
+ * \brief Locking policy for pipes written by a single thread
+ *
+ * Features writing from a background thread of the pipe (scheduled messages, snapshots for
+ * retained identifiers and subscription filtering) need MutexLocking and fail to compile.
+ */
+struct NoLocking {
+    // Only the writing thread may write, see BasicUnixPipe::retain(), filterSubscriptions() and writeAt()
+    static constexpr bool const CONCURRENT = false;
+    struct Mutex {
+        void lock() {}
+        void unlock() {}
+        bool try_lock() {
+            return true;
+        }
+    };
+};
+
+/*
+ * \brief Instrumentation policy counting traffic per identifier once enabled, see BasicUnixPipe::enableStatistics()
+ */
+class IdInstrumentation {
+public:
+    IdStatistics& enable(size_t exactCapacity, size_t topK) {
+        m_statistics.reset(new IdStatistics(exactCapacity, topK));
+        return *m_statistics;
+    }
+
+    IdStatistics const* statistics() const {
+        return m_statistics.get();
+    }
+
+    void record(std::string_view id, size_t bytes) {
+        if (m_statistics) {
+            m_statistics->record(id, bytes);
+        }
+    }
+
+private:
+    // Traffic counters, nullptr until enabled
+    std::unique_ptr<IdStatistics> m_statistics;
+};
+
+/*
+ * \brief Instrumentation policy without any counters
+ */
+class NoInstrumentation {
+public:
+    IdStatistics& enable(size_t, size_t) {
+        throw std::logic_error("Tried to enable statistics on a pipe without instrumentation.");
+    }
+
+    IdStatistics const* statistics() const {
+        return nullptr;
+    }
+
+    void record(std::string_view, size_t) {}
+};
@@ -0,0 +1,362 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "UnixPipe.hxx"
+
+/*
+ * \brief Single thread serving the reader side of many pipes
+ *
+ * Instead of a thread per reader, all registered pipes are watched with one epoll set
+ * (the transport and the eventfd of the in-process channel). Pipes without messages for
+ * PipeConfig::hibernateAfterMs hand their receive buffer back to the BufferPool, so an
+ * idle pipe only costs its object and file descriptors. The next message takes a buffer
+ * out of the pool again. Pipes with data are served by deficit round robin: each turn adds
+ * the weighted quanta of a pipe (PipeConfig::reactorQuantumBytes, reactorQuantumMessages and
+ * reactorWeight) to its deficit, and the pipe reads until that is used up. A pipe with data
+ * left queues up behind the other ready pipes, so a bulk pipe delays a newly ready one by at
+ * most one quantum per ready pipe. Pipes paused by the MemoryGovernor are taken out of the
+ * epoll set and watched again once resumed. Callbacks run on the reactor thread and must not
+ * destroy the pipe they are called for.
+ */
+class PipeReactor {
+public:
+    // Timeout in milliseconds after which the reactor checks for stop requests and idle pipes
+    static constexpr int const POLL_TIMEOUT_MS = 100;
+    // Maximum number of events handled per epoll_wait
+    static constexpr int const MAX_EVENTS = 256;
+
+    PipeReactor() : m_epollFd(epoll_create1(EPOLL_CLOEXEC)), m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_hasToStop(false),
+          m_hibernating(0) {
+        if (m_epollFd == -1 || m_wakeFd == -1) {
+            perror("epoll_create1");
+            abort();
+        }
+        // A null pointer marks the wakeup eventfd of the reactor itself
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) == -1) {
+            perror("epoll_ctl");
+            abort();
+        }
+    }
+
+    PipeReactor(PipeReactor const&) = delete;
+    PipeReactor& operator=(PipeReactor const&) = delete;
+
+    /*
+     * \brief Stop the reactor thread, pipes still registered are no longer served
+     */
+    ~PipeReactor() {
+        if (m_thread && m_thread->joinable()) {
+            m_hasToStop = true;
+            wake();
+            m_thread->join();
+        }
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        for (UnixPipe* pipe : m_pipes) {
+            pipe->m_detach = UnixPipe::Detach();
+        }
+        close(m_wakeFd);
+        close(m_epollFd);
+    }
+
+    /*
+     * \brief Serve the reader side of a pipe, instead of calling start() on it
+     * \param pipe Pipe with read access and all callbacks registered, removed again when it is destroyed
+     */
+    void add(UnixPipe& pipe) {
+        if (pipe.m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to add a pipe with write access only to a reactor.");
+        }
+        if (pipe.m_reader || pipe.m_detach) {
+            throw std::logic_error("Tried to add a running pipe to a reactor.");
+        }
+        pipe.announce();
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        watch(pipe.m_transport->fd(), &pipe);
+        if (pipe.m_local) {
+            watch(pipe.m_local->eventFd(), &pipe);
+        }
+        pipe.m_lastActivity = std::chrono::steady_clock::now();
+        pipe.m_deficitBytes = 0;
+        pipe.m_deficitMessages = 0;
+        pipe.m_detach = [this, &pipe]() {
+            remove(pipe);
+        };
+        m_pipes.insert(&pipe);
+        // Pipes start hibernated, the first message takes a buffer out of the pool
+        ++m_hibernating;
+        // Serve data (and in-process messages, which do not signal the eventfd yet) that arrived before the pipe was added
+        m_pending.push_back(&pipe);
+        wake();
+    }
+
+    /*
+     * \brief Stop serving a pipe, waits until its callbacks returned
+     * \param pipe Pipe previously added
+     */
+    void remove(UnixPipe& pipe) {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        if (m_pipes.erase(&pipe) == 0) {
+            return;
+        }
+        // Descriptors of paused pipes are no longer watched
+        if (m_paused.erase(&pipe) == 0) {
+            unwatch(pipe);
+        }
+        if (m_awake.erase(&pipe) == 0 && pipe.m_input.empty()) {
+            --m_hibernating;
+        }
+        m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), &pipe), m_pending.end());
+        m_ready.erase(std::remove(m_ready.begin(), m_ready.end(), &pipe), m_ready.end());
+        pipe.m_ready = false;
+        pipe.m_detach = UnixPipe::Detach();
+    }
+
+    /*
+     * \brief Start the reactor thread
+     */
+    void start() {
+        if (!m_thread) {
+            m_thread.reset(new std::thread(std::bind(&PipeReactor::run, this)));
+        }
+    }
+
+    /*
+     * \brief Get the number of served pipes
+     */
+    size_t size() const {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        return m_pipes.size();
+    }
+
+    /*
+     * \brief Get the number of served pipes without receive buffer
+     */
+    size_t hibernating() const {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        return m_hibernating;
+    }
+
+private:
+    // Descriptor of the epoll set
+    int m_epollFd;
+    // Wakes the reactor thread for pending pipes and stop requests
+    int m_wakeFd;
+    // Atomic boolean to notify the reactor thread of exit
+    std::atomic<bool> m_hasToStop;
+    // Reactor thread handle
+    std::unique_ptr<std::thread> m_thread;
+    // Guards the pipe sets, held while callbacks run so pipes can only be removed in between (recursive for callbacks adding or removing other pipes)
+    mutable std::recursive_mutex m_mutex;
+    // All served pipes
+    std::unordered_set<UnixPipe*> m_pipes;
+    // Served pipes holding a receive buffer, checked for idleness
+    std::unordered_set<UnixPipe*> m_awake;
+    // Pipes added or resumed since the last round
+    std::vector<UnixPipe*> m_pending;
+    // Pipes with data, served round robin
+    std::deque<UnixPipe*> m_ready;
+    // Pipes paused by the memory governor, not in the epoll set
+    std::unordered_set<UnixPipe*> m_paused;
+    // Number of served pipes without receive buffer
+    size_t m_hibernating;
+
+    /*
+     * \brief Add a descriptor of a pipe to the epoll set
+     */
+    void watch(int fd, UnixPipe* pipe) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = pipe;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            perror("epoll_ctl");
+            throw std::logic_error("Unable to add pipe to reactor.");
+        }
+    }
+
+    /*
+     * \brief Remove the descriptors of a pipe from the epoll set
+     */
+    void unwatch(UnixPipe& pipe) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, pipe.m_transport->fd(), nullptr);
+        if (pipe.m_local) {
+            epoll_ctl(m_epollFd, EPOLL_CTL_DEL, pipe.m_local->eventFd(), nullptr);
+        }
+    }
+
+    /*
+     * \brief Interrupt epoll_wait of the reactor thread
+     */
+    void wake() {
+        uint64_t one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+            perror("write(eventfd)");
+        }
+    }
+
+    /*
+     * \brief Queue a pipe for its next turn unless it is already queued, m_mutex has to be held
+     */
+    void ready(UnixPipe* pipe) {
+        if (!pipe->m_ready) {
+            pipe->m_ready = true;
+            m_ready.push_back(pipe);
+        }
+    }
+
+    /*
+     * \brief Give every ready pipe one turn, pipes with data left queue up again behind the others, m_mutex has to be held
+     */
+    void serveReady() {
+        for (size_t turns = m_ready.size(); turns > 0 && !m_ready.empty(); --turns) {
+            UnixPipe* pipe = m_ready.front();
+            m_ready.pop_front();
+            // A callback may have removed the pipe during its turn
+            if (serve(pipe) && m_pipes.count(pipe) > 0) {
+                m_ready.push_back(pipe);
+            } else {
+                pipe->m_ready = false;
+            }
+        }
+    }
+
+    /*
+     * \brief Add to a deficit without overflow
+     */
+    static size_t topUp(size_t deficit, size_t quantum) {
+        return deficit + std::min(SIZE_MAX - deficit, quantum);
+    }
+
+    /*
+     * \brief Serve one turn of a pipe and track whether it holds a receive buffer, m_mutex has to be held
+     * \return True if the pipe may have data left
+     */
+    bool serve(UnixPipe* pipe) {
+        // Level triggered descriptors of a paused pipe would report its unread data over and over
+        if (!pipe->relieveMemory()) {
+            unwatch(*pipe);
+            m_paused.insert(pipe);
+            pipe->m_deficitBytes = 0;
+            pipe->m_deficitMessages = 0;
+            return false;
+        }
+        PipeConfig const& config = pipe->m_config;
+        pipe->m_deficitBytes = topUp(pipe->m_deficitBytes, config.reactorQuantumBytes * config.reactorWeight);
+        pipe->m_deficitMessages = config.reactorQuantumMessages == 0 ? SIZE_MAX
+            : topUp(pipe->m_deficitMessages, config.reactorQuantumMessages * config.reactorWeight);
+        bool hibernated = pipe->m_input.empty();
+        bool backlogged = pipe->readAvailable();
+        if (hibernated && !pipe->m_input.empty()) {
+            m_awake.insert(pipe);
+            --m_hibernating;
+        }
+        // Transports signaling a sleeping reader only (in memory) are served again if data is left
+        backlogged = backlogged || !pipe->m_transport->prepareSleep();
+        // Pipes without data do not save up deficit
+        if (!backlogged) {
+            pipe->m_deficitBytes = 0;
+            pipe->m_deficitMessages = 0;
+        }
+        return backlogged;
+    }
+
+    /*
+     * \brief Watch pipes the memory governor resumed again and queue them for a turn, m_mutex has to be held
+     */
+    void resumePaused() {
+        for (auto it = m_paused.begin(); it != m_paused.end();) {
+            UnixPipe* pipe = *it;
+            if ((pipe->m_account->requests() & MemoryGovernor::PAUSE) != 0) {
+                ++it;
+                continue;
+            }
+            it = m_paused.erase(it);
+            watch(pipe->m_transport->fd(), pipe);
+            if (pipe->m_local) {
+                watch(pipe->m_local->eventFd(), pipe);
+            }
+            ready(pipe);
+        }
+    }
+
+    /*
+     * \brief Release the receive buffers of pipes idle for longer than configured, m_mutex has to be held
+     */
+    void hibernateIdle() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = m_awake.begin(); it != m_awake.end();) {
+            UnixPipe* pipe = *it;
+            size_t idleAfter = pipe->m_config.hibernateAfterMs;
+            if (idleAfter > 0 && now - pipe->m_lastActivity >= std::chrono::milliseconds(idleAfter) && pipe->hibernate()) {
+                it = m_awake.erase(it);
+                ++m_hibernating;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /*
+     * \brief Main reactor thread routine
+     */
+    void run() {
+        struct epoll_event events[MAX_EVENTS];
+        auto lastSweep = std::chrono::steady_clock::now();
+        bool backlogged = false;
+        while (!m_hasToStop) {
+            // Pipes with data left only pick up new events before their next turn
+            int count = epoll_wait(m_epollFd, events, MAX_EVENTS, backlogged ? 0 : POLL_TIMEOUT_MS);
+            if (count == -1 && errno != EINTR) {
+                perror("epoll_wait");
+                throw std::logic_error("Waiting for pipes failed!");
+            }
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            for (int idx = 0; idx < count; ++idx) {
+                UnixPipe* pipe = static_cast<UnixPipe*>(events[idx].data.ptr);
+                if (pipe == nullptr) {
+                    uint64_t value;
+                    while (::read(m_wakeFd, &value, sizeof(value)) > 0) {}
+                } else if (m_pipes.count(pipe) > 0) {
+                    // Events of pipes removed since epoll_wait returned are skipped
+                    ready(pipe);
+                }
+            }
+            for (UnixPipe* pipe : m_pending) {
+                ready(pipe);
+            }
+            m_pending.clear();
+            serveReady();
+            // Paused pipes are checked at least every POLL_TIMEOUT_MS, resumed ones get a turn in the next round
+            if (!m_paused.empty()) {
+                resumePaused();
+            }
+            backlogged = !m_ready.empty();
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastSweep >= std::chrono::milliseconds(POLL_TIMEOUT_MS)) {
+                hibernateIdle();
+                lastSweep = now;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,714 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * \brief Byte stream carrying the frames of a UnixPipe
+ *
+ * Both directions behave like a non-blocking file descriptor: read() and write() transfer
+ * what is possible and fail with EAGAIN otherwise. A reader about to sleep polls fd() for
+ * POLLIN after prepareSleep() returned true.
+ */
+class PipeTransport {
+public:
+    virtual ~PipeTransport() {}
+
+    /*
+     * \brief Read up to length bytes without blocking
+     * \return Number of bytes read, -1 with errno set (EAGAIN if no data is available)
+     */
+    virtual ssize_t read(char* data, size_t length) = 0;
+
+    /*
+     * \brief Write up to length bytes without blocking
+     * \return Number of bytes written, -1 with errno set (EAGAIN if full)
+     */
+    virtual ssize_t write(char const* data, size_t length) = 0;
+
+    /*
+     * \brief Check without blocking if data is available
+     */
+    virtual bool readable() = 0;
+
+    /*
+     * \brief Wait until there may be room for writing
+     * \param timeoutMs Maximum time to wait
+     */
+    virtual void waitWritable(int timeoutMs) = 0;
+
+    /*
+     * \brief Descriptor polled for POLLIN by a sleeping reader
+     */
+    virtual int fd() const = 0;
+
+    /*
+     * \brief Announce that the reader is going to sleep in poll on fd()
+     * \return False if data arrived meanwhile and the reader has to continue instead
+     */
+    virtual bool prepareSleep() {
+        return true;
+    }
+
+    /*
+     * \brief Reader woke up from poll on fd()
+     */
+    virtual void wakeUp() {}
+
+    /*
+     * \brief Receive buffer size the reader needs to read efficiently, 0 if any size works
+     */
+    virtual size_t batchSize() const {
+        return 0;
+    }
+
+    /*
+     * \brief Check if all writers left since the last call, only reported by transports watching for it
+     */
+    virtual bool hungUp() {
+        return false;
+    }
+};
+
+/*
+ * \brief Transport over a named pipe, the default
+ */
+class FifoTransport : public PipeTransport {
+public:
+    /*
+     * \brief Create the named pipe if missing and open it
+     * \param name Path of the named pipe
+     * \param capacity Kernel pipe capacity set via F_SETPIPE_SZ, 0 keeps the system default
+     * \param detectHangup True to open a reading end only, so hungUp() reports once all writers closed the pipe
+     */
+    FifoTransport(std::string const& name, size_t capacity, bool detectHangup = false)
+        : m_name(name), m_fd(-1), m_received(false), m_hungUp(false) {
+        struct stat st;
+        // Check if pipe exists
+        if (stat(name.c_str(), &st) == 0) {
+            // Check if given name/path is a valid named pipe
+            if (!S_ISFIFO(st.st_mode)) {
+                std::cerr << name << " is not a named pipe." << std::endl;
+            }
+        } else {
+            // Create new named pipe
+            if (mkfifo(name.c_str(), 0666) == -1) {
+                perror("mkfifo");
+                abort();
+            }
+        }
+        // Open named pipe, use O_RDWR to prevent SIGPIPE on exit of reader
+        // Use O_NONBLOCK for writer to prevent blocking on open call and for reader to allow spinning
+        // A pipe watching for hangup must not count as writer itself
+        m_fd = open(name.c_str(), (detectHangup ? O_RDONLY : O_RDWR) | O_NONBLOCK);
+        // Apply kernel pipe capacity if configured
+        if (m_fd != -1 && capacity > 0 && fcntl(m_fd, F_SETPIPE_SZ, static_cast<int>(capacity)) == -1) {
+            perror("fcntl(F_SETPIPE_SZ)");
+        }
+    }
+
+    ~FifoTransport() override {
+        close(m_fd);
+    }
+
+    ssize_t read(char* data, size_t length) override {
+        ssize_t count = ::read(m_fd, data, length);
+        if (count > 0) {
+            m_received = true;
+        } else if (count == 0) {
+            // Only a reading end opened to detect hangups sees end of file, there is no writer right now
+            checkHangup();
+            errno = EAGAIN;
+            return -1;
+        }
+        return count;
+    }
+
+    ssize_t write(char const* data, size_t length) override {
+        return ::write(m_fd, data, length);
+    }
+
+    bool readable() override {
+        struct pollfd pfd = { m_fd, POLLIN, 0 };
+        return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
+    }
+
+    void waitWritable(int timeoutMs) override {
+        struct pollfd pfd = { m_fd, POLLOUT, 0 };
+        poll(&pfd, 1, timeoutMs);
+    }
+
+    int fd() const override {
+        return m_fd;
+    }
+
+    bool hungUp() override {
+        bool hungUp = m_hungUp;
+        m_hungUp = false;
+        return hungUp;
+    }
+
+private:
+    // Path of the named pipe
+    std::string m_name;
+    // File descriptor of the opened named pipe
+    int m_fd;
+    // True if data arrived since the pipe was (re)opened
+    bool m_received;
+    // True if all writers left since the last call of hungUp()
+    bool m_hungUp;
+
+    /*
+     * \brief Record a hangup if writers were there, i.e. data arrived or the kernel reports POLLHUP
+     */
+    void checkHangup() {
+        struct pollfd pfd = { m_fd, POLLIN, 0 };
+        if (!m_received && !(poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLHUP) != 0)) {
+            return;
+        }
+        // Reopen on the same descriptor, POLLHUP stays set until then and pollers keep the descriptor
+        int fd = open(m_name.c_str(), O_RDONLY | O_NONBLOCK);
+        if (fd != -1) {
+            dup2(fd, m_fd);
+            close(fd);
+        }
+        m_received = false;
+        m_hungUp = true;
+    }
+};
+
+/*
+ * \brief Transport over a bounded byte queue in memory, shared by all pipes of the process with the same name
+ *
+ * Frames are encoded and parsed exactly as on a named pipe, but transferring them needs no
+ * system call unless the reader sleeps, which isolates the cost of framing and dispatch.
+ */
+class MemoryTransport : public PipeTransport {
+public:
+    // Capacity of the queue if none is configured, the default capacity of a Linux pipe
+    static constexpr size_t const DEFAULT_CAPACITY = 65536;
+
+    /*
+     * \brief Attach to the queue of the given name, created on first use
+     * \param name Name of the queue
+     * \param capacity Capacity of a new queue in bytes, 0 uses DEFAULT_CAPACITY
+     */
+    MemoryTransport(std::string const& name, size_t capacity) : m_queue(attach(name, capacity > 0 ? capacity : DEFAULT_CAPACITY)) {}
+
+    ssize_t read(char* data, size_t length) override {
+        Queue& queue = *m_queue;
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            count = std::min(length, queue.filled);
+            // Copy in up to two parts, the queue wraps around
+            size_t first = std::min(count, queue.bytes.size() - queue.head);
+            std::memcpy(data, &queue.bytes[queue.head], first);
+            std::memcpy(data + first, &queue.bytes[0], count - first);
+            queue.head = (queue.head + count) % queue.bytes.size();
+            queue.filled -= count;
+        }
+        if (count == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+        queue.space.notify_one();
+        return static_cast<ssize_t>(count);
+    }
+
+    ssize_t write(char const* data, size_t length) override {
+        Queue& queue = *m_queue;
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            count = std::min(length, queue.bytes.size() - queue.filled);
+            // Like on a named pipe, writes up to PIPE_BUF bytes are not interleaved with other writers
+            if (length <= PIPE_BUF && count < length) {
+                count = 0;
+            }
+            size_t tail = (queue.head + queue.filled) % queue.bytes.size();
+            size_t first = std::min(count, queue.bytes.size() - tail);
+            std::memcpy(&queue.bytes[tail], data, first);
+            std::memcpy(&queue.bytes[0], data + first, count - first);
+            queue.filled += count;
+        }
+        if (count == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+        // Sequentially consistent with the sleep announcement in prepareSleep()
+        if (queue.sleeping.load(std::memory_order_seq_cst)) {
+            uint64_t one = 1;
+            if (::write(queue.eventFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+                perror("write(eventfd)");
+            }
+        }
+        return static_cast<ssize_t>(count);
+    }
+
+    bool readable() override {
+        std::lock_guard<std::mutex> lock(m_queue->mutex);
+        return m_queue->filled > 0;
+    }
+
+    void waitWritable(int timeoutMs) override {
+        Queue& queue = *m_queue;
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        // Enough room for any write that is not split
+        queue.space.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&queue]() {
+            return queue.bytes.size() - queue.filled >= std::min<size_t>(PIPE_BUF, queue.bytes.size());
+        });
+    }
+
+    int fd() const override {
+        return m_queue->eventFd;
+    }
+
+    bool prepareSleep() override {
+        m_queue->sleeping.store(true, std::memory_order_seq_cst);
+        if (readable()) {
+            m_queue->sleeping.store(false, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void wakeUp() override {
+        m_queue->sleeping.store(false, std::memory_order_relaxed);
+        uint64_t count;
+        while (::read(m_queue->eventFd, &count, sizeof(count)) > 0) {}
+    }
+
+private:
+    /*
+     * \brief Byte queue shared by the transports of the same name
+     */
+    struct Queue {
+        explicit Queue(size_t capacity) : bytes(capacity), head(0), filled(0), sleeping(false), eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+            if (eventFd == -1) {
+                perror("eventfd");
+                abort();
+            }
+        }
+
+        ~Queue() {
+            close(eventFd);
+        }
+
+        // Guards the queued bytes
+        std::mutex mutex;
+        // Signals writers waiting for room
+        std::condition_variable space;
+        // Ring of queued bytes
+        std::vector<char> bytes;
+        // Position of the oldest queued byte
+        size_t head;
+        // Number of queued bytes
+        size_t filled;
+        // True while the reader sleeps or is about to
+        std::atomic<bool> sleeping;
+        // Wakes the sleeping reader
+        int eventFd;
+    };
+
+    // Queue of the transport
+    std::shared_ptr<Queue> m_queue;
+
+    /*
+     * \brief Get the queue of a name, shared by all transports of the process opened with the same name
+     */
+    static std::shared_ptr<Queue> attach(std::string const& name, size_t capacity) {
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<Queue>> registry;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<Queue> queue = registry[name].lock();
+        if (!queue) {
+            queue = std::make_shared<Queue>(capacity);
+            registry[name] = queue;
+        }
+        return queue;
+    }
+};
+
+/*
+ * \brief Transport over a Unix SOCK_SEQPACKET socket bound to the pipe name, message boundaries are preserved
+ *
+ * Writers connect to the socket of the reader and split every write into packets of at most
+ * PACKET_SIZE bytes. Each packet starts with a header byte, CONTINUED if the write goes on in the
+ * next packet and FINAL for its last one, so a write of less than PACKET_SIZE bytes is one packet.
+ * The reader stays on a connection until it received a FINAL packet, so frames of different
+ * writers are never interleaved, whatever their length. It fetches up to BATCH_PACKETS packets per recvmmsg
+ * into slots of its receive buffer and compacts their payloads, frames then always start at a
+ * packet boundary. Unlike the named pipe the socket holds no data without a reader: writers wait
+ * until a reader listens.
+ */
+class SeqPacketTransport : public PipeTransport {
+public:
+    // Maximum size of a packet including its header byte
+    static constexpr size_t const PACKET_SIZE = PIPE_BUF;
+    // Header byte of a packet whose write continues in the next packet, the last packet of a write has FINAL
+    static constexpr char const CONTINUED = 1;
+    static constexpr char const FINAL = 0;
+    // Maximum number of packets fetched per recvmmsg
+    static constexpr size_t const BATCH_PACKETS = 16;
+
+    /*
+     * \brief Listen on the socket of the given name as reader or prepare connecting to it as writer
+     * \param name Path of the socket, a stale socket of a previous reader is replaced
+     * \param reader True to listen for writers, false to connect to the reader on the first write
+     * \param capacity Send buffer size of writers set via SO_SNDBUF, 0 keeps the system default
+     */
+    SeqPacketTransport(std::string const& name, bool reader, size_t capacity)
+        : m_name(name), m_reader(reader), m_capacity(capacity), m_fd(-1), m_epollFd(-1), m_current(0), m_continued(false), m_focused(false),
+          m_pendingOffset(0) {
+        std::memset(&m_address, 0, sizeof(m_address));
+        m_address.sun_family = AF_UNIX;
+        if (name.size() >= sizeof(m_address.sun_path)) {
+            std::cerr << name << " is too long for a socket path." << std::endl;
+            abort();
+        }
+        std::memcpy(m_address.sun_path, name.c_str(), name.size() + 1);
+        if (!reader) {
+            return;
+        }
+        struct stat st;
+        if (stat(name.c_str(), &st) == 0) {
+            if (S_ISSOCK(st.st_mode)) {
+                unlink(name.c_str());
+            } else {
+                std::cerr << name << " is not a socket." << std::endl;
+            }
+        }
+        m_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_fd == -1 || bind(m_fd, reinterpret_cast<struct sockaddr*>(&m_address), sizeof(m_address)) == -1 || listen(m_fd, SOMAXCONN) == -1) {
+            perror("seqpacket listen");
+            abort();
+        }
+        // Readable once a writer connects or any connection has packets
+        m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (m_epollFd == -1) {
+            perror("epoll_create1");
+            abort();
+        }
+        watch(m_fd);
+    }
+
+    ~SeqPacketTransport() override {
+        for (int connection : m_connections) {
+            close(connection);
+        }
+        if (m_epollFd != -1) {
+            close(m_epollFd);
+        }
+        if (m_fd != -1) {
+            close(m_fd);
+        }
+        if (m_reader) {
+            unlink(m_name.c_str());
+        }
+    }
+
+    ssize_t read(char* data, size_t length) override {
+        // Rest of a packet that did not fit into the buffer of the previous call
+        if (m_pendingOffset < m_pending.size()) {
+            size_t count = std::min(length, m_pending.size() - m_pendingOffset);
+            std::memcpy(data, &m_pending[m_pendingOffset], count);
+            m_pendingOffset += count;
+            return static_cast<ssize_t>(count);
+        }
+        for (size_t attempt = 0; attempt < 2; ++attempt) {
+            // A write split into several packets is read completely before other connections
+            for (size_t tries = 0; tries < (m_continued ? 1 : m_connections.size()); ++tries) {
+                ssize_t count = receive(data, length);
+                if (count > 0) {
+                    return count;
+                }
+            }
+            // Only look for new writers once all connections are drained
+            if (!accept()) {
+                break;
+            }
+        }
+        errno = EAGAIN;
+        return -1;
+    }
+
+    ssize_t write(char const* data, size_t length) override {
+        if (m_fd == -1 && !connect()) {
+            errno = EAGAIN;
+            return -1;
+        }
+        // The header byte marks the end of the write explicitly
+        size_t payload = std::min(length, PACKET_SIZE - 1);
+        char header = payload < length ? CONTINUED : FINAL;
+        struct iovec vectors[2] = { { &header, 1 }, { const_cast<char*>(data), payload } };
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = vectors;
+        message.msg_iovlen = 2;
+        ssize_t written = ::sendmsg(m_fd, &message, MSG_NOSIGNAL);
+        // The reader is gone, connect to the next one
+        if (written == -1 && (errno == EPIPE || errno == ECONNRESET || errno == ENOTCONN)) {
+            close(m_fd);
+            m_fd = -1;
+            errno = EAGAIN;
+        }
+        return written > 0 ? written - 1 : written;
+    }
+
+    bool readable() override {
+        if (m_pendingOffset < m_pending.size()) {
+            return true;
+        }
+        struct pollfd pfd = { m_epollFd, POLLIN, 0 };
+        return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
+    }
+
+    void waitWritable(int timeoutMs) override {
+        if (m_fd == -1) {
+            // No reader to connect to yet
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return;
+        }
+        struct pollfd pfd = { m_fd, POLLOUT, 0 };
+        poll(&pfd, 1, timeoutMs);
+    }
+
+    int fd() const override {
+        return m_reader ? m_epollFd : m_fd;
+    }
+
+    bool prepareSleep() override {
+        if (m_pendingOffset < m_pending.size()) {
+            return false;
+        }
+        // In the middle of a write only its connection is read, data of the others must not wake the reader over and over
+        focus(m_continued);
+        return true;
+    }
+
+    size_t batchSize() const override {
+        return PACKET_SIZE * BATCH_PACKETS;
+    }
+
+private:
+    // Path of the socket
+    std::string m_name;
+    // True if listening for writers
+    bool m_reader;
+    // Send buffer size of writers, 0 keeps the system default
+    size_t m_capacity;
+    // Listening socket of the reader or connected socket of a writer, -1 if not connected
+    int m_fd;
+    // Epoll instance watching the listening socket and all connections of the reader
+    int m_epollFd;
+    // Address of the socket
+    struct sockaddr_un m_address;
+    // Connections of the writers
+    std::vector<int> m_connections;
+    // Index of the connection read next
+    size_t m_current;
+    // True if the last packet of the current connection had the CONTINUED header
+    bool m_continued;
+    // True while the epoll instance only watches the current connection, see focus()
+    bool m_focused;
+    // Packet that did not fit into the receive buffer, handed out by the next reads
+    std::string m_pending;
+    // Number of bytes of m_pending already handed out
+    size_t m_pendingOffset;
+
+    void watch(int fd) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            perror("epoll_ctl");
+        }
+    }
+
+    /*
+     * \brief Watch only the current connection or again the listening socket and all connections
+     * \param focused True to remove the others from the epoll instance, level-triggered events (and hangups) of them would wake the reader at once
+     */
+    void focus(bool focused) {
+        if (focused == m_focused) {
+            return;
+        }
+        m_focused = focused;
+        int current = m_connections.empty() ? -1 : m_connections[m_current];
+        for (size_t idx = 0; idx <= m_connections.size(); ++idx) {
+            int fd = idx < m_connections.size() ? m_connections[idx] : m_fd;
+            if (fd == current) {
+                continue;
+            } else if (focused) {
+                epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            } else {
+                watch(fd);
+            }
+        }
+    }
+
+    /*
+     * \brief Connect a writer to the listening reader
+     * \return False if no reader listens
+     */
+    bool connect() {
+        m_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_fd == -1) {
+            perror("socket");
+            return false;
+        }
+        if (m_capacity > 0) {
+            int size = static_cast<int>(m_capacity);
+            setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        }
+        if (::connect(m_fd, reinterpret_cast<struct sockaddr*>(&m_address), sizeof(m_address)) == -1) {
+            close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * \brief Accept all writers waiting to connect
+     * \return True if any writer connected
+     */
+    bool accept() {
+        bool any = false;
+        int connection;
+        while ((connection = accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+            // Watched once the current write is complete
+            if (!m_focused) {
+                watch(connection);
+            }
+            m_connections.push_back(connection);
+            any = true;
+        }
+        return any;
+    }
+
+    /*
+     * \brief Receive a batch of packets of the current connection, moves on to the next one once it is drained
+     * \return Number of bytes stored contiguously at data, 0 if none were available
+     */
+    ssize_t receive(char* data, size_t length) {
+        int connection = m_connections[m_current];
+        size_t slots = std::min(BATCH_PACKETS, length / PACKET_SIZE);
+        if (slots == 0) {
+            return receiveSmall(connection, data, length);
+        }
+        struct iovec vectors[BATCH_PACKETS];
+        struct mmsghdr headers[BATCH_PACKETS];
+        std::memset(headers, 0, sizeof(headers[0]) * slots);
+        for (size_t slot = 0; slot < slots; ++slot) {
+            vectors[slot].iov_base = data + slot * PACKET_SIZE;
+            vectors[slot].iov_len = PACKET_SIZE;
+            headers[slot].msg_hdr.msg_iov = &vectors[slot];
+            headers[slot].msg_hdr.msg_iovlen = 1;
+        }
+        int count = recvmmsg(connection, headers, static_cast<unsigned int>(slots), MSG_DONTWAIT, nullptr);
+        if (count <= 0) {
+            if (count == -1 && errno != EAGAIN) {
+                disconnect();
+            } else {
+                next();
+            }
+            return 0;
+        }
+        // Move the payloads together without their headers, each one moves towards the front
+        size_t filled = 0;
+        bool closed = false;
+        for (int idx = 0; idx < count; ++idx) {
+            size_t packet = headers[idx].msg_len;
+            // Writers never send empty packets, an empty one is the end of the connection
+            if (packet == 0) {
+                closed = true;
+                break;
+            }
+            char const* slot = data + idx * PACKET_SIZE;
+            m_continued = slot[0] == CONTINUED;
+            std::memmove(data + filled, slot + 1, packet - 1);
+            filled += packet - 1;
+        }
+        if (closed) {
+            disconnect();
+        } else if (static_cast<size_t>(count) < slots) {
+            next();
+        }
+        return static_cast<ssize_t>(filled);
+    }
+
+    /*
+     * \brief Receive one packet into a buffer with room for less than PACKET_SIZE bytes, the rest is kept for the next read
+     */
+    ssize_t receiveSmall(int connection, char* data, size_t length) {
+        m_pending.resize(PACKET_SIZE);
+        ssize_t packet = ::recv(connection, &m_pending[0], PACKET_SIZE, MSG_DONTWAIT);
+        if (packet <= 0) {
+            m_pending.clear();
+            if (packet == 0 || errno != EAGAIN) {
+                disconnect();
+            } else {
+                next();
+            }
+            return 0;
+        }
+        // The header byte is skipped like a handed out byte
+        size_t count = std::min(length, static_cast<size_t>(packet) - 1);
+        std::memcpy(data, &m_pending[1], count);
+        m_continued = m_pending[0] == CONTINUED;
+        m_pending.resize(packet);
+        m_pendingOffset = 1 + count;
+        return static_cast<ssize_t>(count);
+    }
+
+    /*
+     * \brief Move on to the next connection unless the current one is in the middle of a write
+     */
+    void next() {
+        if (!m_continued) {
+            m_current = (m_current + 1) % m_connections.size();
+        }
+    }
+
+    /*
+     * \brief Close the current connection, its writer is gone
+     */
+    void disconnect() {
+        // A write cut off by its writer is never continued
+        focus(false);
+        close(m_connections[m_current]);
+        m_connections.erase(m_connections.begin() + m_current);
+        m_continued = false;
+        if (m_current >= m_connections.size()) {
+            m_current = 0;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,376 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <charconv>
+#include <condition_variable>
+
+#include "PipeJournal.hxx"
+#include "UnixPipe.hxx"
+
+/*
+ * \brief Protocol shared by ReliableWriter and ReliableReader
+ *
+ * Messages travel on the named pipe NAME as frames of identifier ENVELOPE with the content
+ * "<sequence>:<id length>:<id><message>". The reader answers on the named pipe NAME.ack
+ * with ACK (processed up to sequence, batched) and HELLO (processed up to sequence, resend
+ * everything after). HELLO is sent when the reader starts and when it receives RESUME from
+ * a restarted writer.
+ */
+struct ReliableProtocol {
+    // Suffix of the control pipe carrying acknowledgements from reader to writer, distinct from UnixPipe::CONTROL_SUFFIX of the data pipe
+    constexpr static const char* const CONTROL_SUFFIX = ".ack";
+    // Suffix of the writer journal file
+    constexpr static const char* const JOURNAL_SUFFIX = ".journal";
+    // Suffix of the reader state file
+    constexpr static const char* const STATE_SUFFIX = ".state";
+    // Message identifiers of the protocol
+    constexpr static const char* const ENVELOPE = "RELIABLE";
+    constexpr static const char* const RESUME = "RESUME";
+    constexpr static const char* const ACK = "ACK";
+    constexpr static const char* const HELLO = "HELLO";
+
+    /*
+     * \brief Parse a decimal sequence number, 0 if invalid
+     */
+    static uint64_t parseSequence(std::string_view text) {
+        uint64_t sequence = 0;
+        std::from_chars(text.data(), text.data() + text.size(), sequence);
+        return sequence;
+    }
+};
+
+/*
+ * \brief Writing end of an exactly-once pipe
+ *
+ * Each message is stored in a memory mapped journal before it is sent and stays there until
+ * the reader acknowledged it. Unacknowledged messages are sent again when the reader (re)starts
+ * or when the writer restarts after a crash, duplicates are suppressed by the reader.
+ */
+class ReliableWriter {
+public:
+    // Default number of bytes of the journal, writes wait for acknowledgements if it is full
+    static constexpr size_t const DEFAULT_JOURNAL_SIZE = 4 * 1024 * 1024;
+
+    /*
+     * \brief Create the writer, unacknowledged messages of a previous writer are recovered
+     * \param name Name of the pipe file (path), the control pipe and the journal are placed next to it
+     * \param journalSize Number of bytes of the journal
+     * \param config Tuning parameters of both pipes
+     */
+    ReliableWriter(std::string const name, size_t journalSize = DEFAULT_JOURNAL_SIZE, PipeConfig const config = PipeConfig::fromEnvironment())
+        : m_journal(name + ReliableProtocol::JOURNAL_SUFFIX, journalSize),
+          m_data(name, PipeAccess::Write, config),
+          m_control(name + ReliableProtocol::CONTROL_SUFFIX, PipeAccess::Read, config) {
+        m_control.addCallback(ReliableProtocol::ACK, [this](std::string const& msg) {
+            acknowledge(ReliableProtocol::parseSequence(msg), false);
+        });
+        m_control.addCallback(ReliableProtocol::HELLO, [this](std::string const& msg) {
+            acknowledge(ReliableProtocol::parseSequence(msg), true);
+        });
+        m_control.start();
+        // Ask a running reader where to resume, the previous writer may have lost frames it had not written yet
+        if (m_journal.pending() > 0) {
+            m_data.tryWrite(ReliableProtocol::RESUME, "");
+        }
+    }
+
+    /*
+     * \brief Journal and send the message associated with given identifier
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     */
+    void write(std::string const& id, std::string const& msg) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // Wait for acknowledgements if the journal is full
+        while (!m_journal.fits(id.size(), msg.size())) {
+            m_space.wait(lock);
+        }
+        uint64_t sequence = m_journal.append(id, msg);
+        m_data.write(ReliableProtocol::ENVELOPE, envelope(sequence, id, msg));
+    }
+
+    /*
+     * \brief Write all frames held back for coalescing
+     */
+    void flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_data.flush();
+    }
+
+    /*
+     * \brief Get the number of sent but not yet acknowledged messages
+     */
+    uint64_t pending() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_journal.pending();
+    }
+
+private:
+    // Journal of unacknowledged messages
+    PipeJournal m_journal;
+    // Pipe carrying the messages
+    UnixPipe m_data;
+    // Serializes writers and acknowledgements
+    std::mutex m_mutex;
+    // Signaled when acknowledgements freed journal space
+    std::condition_variable m_space;
+    // Pipe carrying acknowledgements, destroyed first as its reader thread uses all other members
+    UnixPipe m_control;
+
+    /*
+     * \brief Build the frame content of a message
+     */
+    static std::string envelope(uint64_t sequence, std::string_view id, std::string_view msg) {
+        std::string content = std::to_string(sequence) + ":" + std::to_string(id.size()) + ":";
+        content.reserve(content.size() + id.size() + msg.size());
+        content.append(id).append(msg);
+        return content;
+    }
+
+    /*
+     * \brief Release acknowledged messages and optionally resend the remaining ones
+     * \param sequence Last sequence processed by the reader
+     * \param resend True if the reader (re)started and expects all later messages again
+     */
+    void acknowledge(uint64_t sequence, bool resend) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // The reader is ahead if the journal was recreated, continue after its position
+        m_journal.skipTo(sequence + 1);
+        m_journal.acknowledge(sequence);
+        if (resend) {
+            m_journal.forEach([this](uint64_t current, std::string_view id, std::string_view msg) {
+                m_data.write(ReliableProtocol::ENVELOPE, envelope(current, id, msg));
+            });
+            m_data.flush();
+        }
+        m_space.notify_all();
+    }
+};
+
+/*
+ * \brief Reading end of an exactly-once pipe
+ *
+ * The sequence of the last processed message is kept in a memory mapped state file and
+ * updated after each callback, messages up to it are dropped as duplicates. Only the message
+ * following it is processed, later ones are dropped until the writer resends them in order
+ * (they were left behind by a killed reader that had read their predecessors). Processed
+ * sequences are acknowledged once ackBatch messages are pending or after ACK_INTERVAL_MS.
+ */
+class ReliableReader {
+public:
+    // Default number of processed messages acknowledged at once
+    static constexpr size_t const DEFAULT_ACK_BATCH = 256;
+    // Maximum delay of an acknowledgement in milliseconds
+    static constexpr int const ACK_INTERVAL_MS = 10;
+
+    using Callback = UnixPipe::Callback;
+
+    /*
+     * \brief Create the reader
+     * \param name Name of the pipe file (path), the control pipe and the state are placed next to it
+     * \param ackBatch Number of processed messages acknowledged at once
+     * \param config Tuning parameters of both pipes
+     */
+    ReliableReader(std::string const name, size_t ackBatch = DEFAULT_ACK_BATCH, PipeConfig const config = PipeConfig::fromEnvironment())
+        : m_state(name + ReliableProtocol::STATE_SUFFIX, sizeof(uint64_t)),
+          m_processed(load()), m_acknowledged(m_processed.load()), m_duplicates(0), m_gaps(0), m_ackBatch(std::max<size_t>(ackBatch, 1)),
+          m_helloPending(false), m_hasToStop(false),
+          m_control(name + ReliableProtocol::CONTROL_SUFFIX, PipeAccess::Write, config),
+          m_data(name, PipeAccess::Read, config) {
+        m_data.addViewCallback(ReliableProtocol::ENVELOPE, [this](std::string_view content) {
+            receive(content);
+        });
+        m_data.addCallback(ReliableProtocol::RESUME, [this](std::string const&) {
+            hello();
+        });
+    }
+
+    /*
+     * \brief Stop receiving and acknowledge all processed messages
+     */
+    ~ReliableReader() {
+        if (m_acknowledger.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_ackMutex);
+                m_hasToStop = true;
+            }
+            m_ackSignal.notify_all();
+            m_acknowledger.join();
+        }
+        acknowledge();
+    }
+
+    /*
+     * \brief Request all unprocessed messages from the writer and start receiving
+     */
+    void start() {
+        if (!m_acknowledger.joinable()) {
+            // A previous reader may have processed more since construction, resending starts right after its progress
+            m_processed.store(load(), std::memory_order_release);
+            hello();
+            m_data.start();
+            m_acknowledger = std::thread(&ReliableReader::handleAcknowledgements, this);
+        }
+    }
+
+    /*
+     * \brief Add callback for a given message identifier, has to be called before start()
+     * \param id Message identifier to use for the callback
+     * \param callback Callback to call for the message identifier
+     */
+    void addCallback(std::string const id, Callback callback) {
+        if (!m_callbacks.emplace(id, std::move(callback)).second) {
+            throw std::logic_error("Tried to add a second callback for the same identifier.");
+        }
+    }
+
+    /*
+     * \brief Get the sequence of the last processed message
+     */
+    uint64_t processed() const {
+        return m_processed.load(std::memory_order_acquire);
+    }
+
+    /*
+     * \brief Get the number of dropped duplicates
+     */
+    uint64_t duplicates() const {
+        return m_duplicates.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Get the number of messages dropped since they did not follow the last processed one
+     */
+    uint64_t gaps() const {
+        return m_gaps.load(std::memory_order_relaxed);
+    }
+
+private:
+    // State file holding the sequence of the last processed message
+    MappedFile m_state;
+    // Sequence of the last processed message
+    std::atomic<uint64_t> m_processed;
+    // Sequence of the last acknowledged message
+    std::atomic<uint64_t> m_acknowledged;
+    // Number of dropped duplicates
+    std::atomic<uint64_t> m_duplicates;
+    // Number of messages dropped after a gap
+    std::atomic<uint64_t> m_gaps;
+    // Number of processed messages acknowledged at once
+    size_t m_ackBatch;
+    // Map of message identifiers associated with its callback
+    std::map<std::string, Callback, std::less<>> m_callbacks;
+    // HELLO that did not fit into the control pipe yet, sent instead of the next acknowledgement, guarded by m_ackMutex
+    bool m_helloPending;
+    // Serializes acknowledgements and guards stop requests of the acknowledgement thread
+    std::mutex m_ackMutex;
+    // Wakes the acknowledgement thread on stop requests
+    std::condition_variable m_ackSignal;
+    // Set to notify the acknowledgement thread of exit
+    bool m_hasToStop;
+    // Thread acknowledging processed messages of incomplete batches
+    std::thread m_acknowledger;
+    // Pipe carrying acknowledgements
+    UnixPipe m_control;
+    // Pipe carrying the messages, destroyed first as its reader thread uses all other members
+    UnixPipe m_data;
+
+    uint64_t load() const {
+        uint64_t sequence;
+        std::memcpy(&sequence, m_state.data(), sizeof(sequence));
+        return sequence;
+    }
+
+    /*
+     * \brief Handle a received envelope
+     * \param content Frame content "<sequence>:<id length>:<id><message>"
+     */
+    void receive(std::string_view content) {
+        size_t posSequence = content.find(':');
+        size_t posIdLength = content.find(':', posSequence + 1);
+        if (posIdLength == std::string::npos) {
+            return;
+        }
+        uint64_t sequence = ReliableProtocol::parseSequence(content.substr(0, posSequence));
+        size_t idLength = ReliableProtocol::parseSequence(content.substr(posSequence + 1, posIdLength - posSequence - 1));
+        if (sequence == 0 || idLength > content.size() - posIdLength - 1) {
+            return;
+        }
+        // Drop messages processed before, e.g. resent after a restart
+        uint64_t processed = m_processed.load(std::memory_order_relaxed);
+        if (sequence <= processed) {
+            m_duplicates.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Drop messages after a gap, e.g. left in the pipe by a killed reader that had read their predecessors,
+        // the writer resends them in order after the last processed message
+        if (sequence != processed + 1) {
+            m_gaps.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::string_view id = content.substr(posIdLength + 1, idLength);
+        auto callback = m_callbacks.find(id);
+        if (callback != m_callbacks.end()) {
+            callback->second(std::string(content.substr(posIdLength + 1 + idLength)));
+        }
+        // Persist progress, a crash from here on does not process the message again
+        std::memcpy(m_state.data(), &sequence, sizeof(sequence));
+        m_processed.store(sequence, std::memory_order_release);
+        if (sequence - m_acknowledged.load(std::memory_order_relaxed) >= m_ackBatch) {
+            acknowledge();
+        }
+    }
+
+    /*
+     * \brief Acknowledge all processed messages if the control pipe has room, skipped acknowledgements are covered by later ones
+     */
+    void acknowledge() {
+        std::lock_guard<std::mutex> lock(m_ackMutex);
+        sendAcknowledgement();
+    }
+
+    /*
+     * \brief Tell the writer the last processed message to receive all later ones
+     *
+     * Called by the data reader thread on RESUME, so it must not wait for room in the control
+     * pipe: the writer may wait for room in the data pipe at the same time. A HELLO that does
+     * not fit is sent by the acknowledgement thread instead of its next acknowledgement.
+     */
+    void hello() {
+        std::lock_guard<std::mutex> lock(m_ackMutex);
+        m_helloPending = true;
+        sendAcknowledgement();
+    }
+
+    /*
+     * \brief Send a pending HELLO or an acknowledgement of all processed messages if the control pipe has room, m_ackMutex has to be held
+     */
+    void sendAcknowledgement() {
+        uint64_t sequence = m_processed.load(std::memory_order_acquire);
+        if (m_helloPending) {
+            // A later HELLO carries the progress made meanwhile, resending starts right after it
+            if (m_control.tryWrite(ReliableProtocol::HELLO, std::to_string(sequence))) {
+                m_helloPending = false;
+                m_acknowledged.store(sequence, std::memory_order_relaxed);
+            }
+        } else if (sequence != m_acknowledged.load(std::memory_order_relaxed) && m_control.tryWrite(ReliableProtocol::ACK, std::to_string(sequence))) {
+            m_acknowledged.store(sequence, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * \brief Acknowledgement thread routine covering batches that do not fill up
+     */
+    void handleAcknowledgements() {
+        std::unique_lock<std::mutex> lock(m_ackMutex);
+        while (!m_hasToStop) {
+            m_ackSignal.wait_for(lock, std::chrono::milliseconds(ACK_INTERVAL_MS));
+            lock.unlock();
+            acknowledge();
+            lock.lock();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,451 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "UnixPipe.hxx"
+
+/*
+ * \brief Runtime support of the code generated by pipe-cxx-schemac
+ *
+ * Every wire type T has a schema::Traits<T> specialization providing
+ * - View: type returned by accessors reading T in place
+ * - FIXED_SIZE: encoded size if it is the same for all values, 0 otherwise
+ * - encodedSize(value) / encode(value, out): serialization into a caller provided buffer
+ * - wireSize(data): size of an already validated encoded value
+ * - validate(data, available): size of the encoded value or INVALID if it is malformed
+ * - view(data): in-place view of an already validated encoded value
+ *
+ * Records are laid out like FlatBuffers tables so that every field and array
+ * element is reached in constant time from the start of its record:
+ * - scalars are stored in host (little endian) byte order
+ * - strings are a 32 bit length followed by the characters
+ * - structs of fixed size fields are stored packed without header
+ * - other structs start with their 32 bit total size and a table of 32 bit field
+ *   offsets (relative to the struct start) followed by the fields
+ * - arrays of fixed size elements are a 32 bit count followed by the packed elements
+ * - other arrays start with their 32 bit total size, the 32 bit count and a table of
+ *   32 bit element offsets (relative to the array start) followed by the elements
+ *
+ * All lengths and offsets are checked by validate() once when a record is received,
+ * accessors of views rely on it and perform no further checks.
+ */
+namespace schema {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "The wire format requires a little endian host.");
+
+// Type of lengths, counts and offsets
+using Length = uint32_t;
+// Returned by validate() if the encoded value is malformed
+static constexpr size_t const INVALID = SIZE_MAX;
+
+template<typename T, typename Enable = void>
+struct Traits;
+
+/*
+ * \brief Load a value from a possibly unaligned address
+ */
+template<typename T>
+inline T load(char const* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/*
+ * \brief Store a value to a possibly unaligned address
+ * \return Address behind the stored value
+ */
+template<typename T>
+inline char* store(char* out, T const& value) {
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+/*
+ * \brief Fixed size of a struct, 0 if any of the field sizes is 0 (variable)
+ */
+constexpr size_t fixedSize(std::initializer_list<size_t> sizes) {
+    size_t total = 0;
+    for (size_t size : sizes) {
+        if (size == 0) {
+            return 0;
+        }
+        total += size;
+    }
+    return total;
+}
+
+/*
+ * \brief Validate a table of offsets and the entries they point to
+ * \param data Start of the record
+ * \param size Total size of the record
+ * \param table Start of the offset table
+ * \param count Number of entries
+ * \param validateEntry Callable validating entry idx at the given address with the given space
+ * \return True if the offsets lie in the record and every entry directly follows the previous one
+ */
+template<typename ValidateEntry>
+inline bool validateTable(char const* data, size_t size, char const* table, size_t count, ValidateEntry&& validateEntry) {
+    size_t position = (table - data) + count * sizeof(Length);
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (load<Length>(table + idx * sizeof(Length)) != position) {
+            return false;
+        }
+        size_t entry = validateEntry(idx, data + position, size - position);
+        if (entry == INVALID) {
+            return false;
+        }
+        position += entry;
+    }
+    return position == size;
+}
+
+/*
+ * \brief Layout of a struct with the given field types, used by the generated Traits and views
+ */
+template<typename... Fields>
+struct Layout {
+    // Number of fields
+    static constexpr size_t const COUNT = sizeof...(Fields);
+    // Encoded size if all fields have a fixed size, 0 otherwise
+    static constexpr size_t const FIXED_SIZE = fixedSize({ Traits<Fields>::FIXED_SIZE... });
+    // Size of the total size and the offset table, no header for fixed size structs
+    static constexpr size_t const HEADER = FIXED_SIZE > 0 ? 0 : sizeof(Length) * (1 + COUNT);
+
+    // Type of field K
+    template<size_t K>
+    using Field = std::tuple_element_t<K, std::tuple<Fields...>>;
+
+    /*
+     * \brief Offset of field K relative to the struct start
+     */
+    template<size_t K>
+    static size_t offset(char const* data) {
+        if constexpr (FIXED_SIZE > 0) {
+            constexpr size_t sizes[] = { Traits<Fields>::FIXED_SIZE... };
+            size_t offset = 0;
+            for (size_t idx = 0; idx < K; ++idx) {
+                offset += sizes[idx];
+            }
+            return offset;
+        } else {
+            return load<Length>(data + sizeof(Length) * (1 + K));
+        }
+    }
+
+    /*
+     * \brief In-place view of field K
+     */
+    template<size_t K>
+    static typename Traits<Field<K>>::View field(char const* data) {
+        return Traits<Field<K>>::view(data + offset<K>(data));
+    }
+
+    static size_t encodedSize(Fields const&... values) {
+        return HEADER + (Traits<Fields>::encodedSize(values) + ... + 0);
+    }
+
+    static char* encode(char* out, Fields const&... values) {
+        if constexpr (FIXED_SIZE > 0) {
+            ((out = Traits<Fields>::encode(values, out)), ...);
+            return out;
+        } else {
+            char* position = out + HEADER;
+            char* table = out + sizeof(Length);
+            ((table = store(table, static_cast<Length>(position - out)), position = Traits<Fields>::encode(values, position)), ...);
+            store(out, static_cast<Length>(position - out));
+            return position;
+        }
+    }
+
+    static size_t wireSize(char const* data) {
+        if constexpr (FIXED_SIZE > 0) {
+            return FIXED_SIZE;
+        } else {
+            return load<Length>(data);
+        }
+    }
+
+    static size_t validate(char const* data, size_t available) {
+        using Validate = size_t (*)(char const*, size_t);
+        static constexpr Validate const validators[] = { &Traits<Fields>::validate... };
+        if constexpr (FIXED_SIZE > 0) {
+            if (available < FIXED_SIZE) {
+                return INVALID;
+            }
+            size_t position = 0;
+            for (Validate validator : validators) {
+                size_t field = validator(data + position, FIXED_SIZE - position);
+                if (field == INVALID) {
+                    return INVALID;
+                }
+                position += field;
+            }
+            return FIXED_SIZE;
+        } else {
+            if (available < HEADER || load<Length>(data) < HEADER || load<Length>(data) > available) {
+                return INVALID;
+            }
+            size_t size = load<Length>(data);
+            bool valid = validateTable(data, size, data + sizeof(Length), COUNT, [](size_t idx, char const* entry, size_t space) {
+                return validators[idx](entry, space);
+            });
+            return valid ? size : INVALID;
+        }
+    }
+};
+
+/*
+ * \brief In-place view of an encoded array, all elements are accessed in constant time
+ */
+template<typename T>
+class ArrayView {
+public:
+    /*
+     * \brief Forward iterator over the elements
+     */
+    class Iterator {
+    public:
+        Iterator(ArrayView const& array, size_t index) : m_array(array), m_index(index) {}
+
+        typename Traits<T>::View operator*() const {
+            return m_array[m_index];
+        }
+
+        Iterator& operator++() {
+            ++m_index;
+            return *this;
+        }
+
+        bool operator!=(Iterator const& other) const {
+            return m_index != other.m_index;
+        }
+
+    private:
+        ArrayView const& m_array;
+        size_t m_index;
+    };
+
+    /*
+     * \brief Create view from the start of an encoded array
+     */
+    explicit ArrayView(char const* data) : m_data(data) {}
+
+    /*
+     * \brief Number of elements
+     */
+    size_t size() const {
+        return load<Length>(m_data + (Traits<T>::FIXED_SIZE > 0 ? 0 : sizeof(Length)));
+    }
+
+    /*
+     * \brief Access element
+     */
+    typename Traits<T>::View operator[](size_t index) const {
+        if constexpr (Traits<T>::FIXED_SIZE > 0) {
+            return Traits<T>::view(m_data + sizeof(Length) + index * Traits<T>::FIXED_SIZE);
+        } else {
+            return Traits<T>::view(m_data + load<Length>(m_data + sizeof(Length) * (2 + index)));
+        }
+    }
+
+    Iterator begin() const {
+        return Iterator(*this, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(*this, size());
+    }
+
+private:
+    char const* m_data;
+};
+
+/*
+ * \brief Scalars (bool, integers, floating point)
+ */
+template<typename T>
+struct Traits<T, std::enable_if_t<std::is_arithmetic<T>::value>> {
+    using View = T;
+    static constexpr size_t const FIXED_SIZE = sizeof(T);
+
+    static size_t encodedSize(T const&) {
+        return sizeof(T);
+    }
+
+    static char* encode(T const& value, char* out) {
+        return store(out, value);
+    }
+
+    static size_t wireSize(char const*) {
+        return sizeof(T);
+    }
+
+    static size_t validate(char const* data, size_t available) {
+        if (available < sizeof(T)) {
+            return INVALID;
+        }
+        // Only 0 and 1 are valid object representations of bool
+        if (std::is_same<T, bool>::value && static_cast<unsigned char>(data[0]) > 1) {
+            return INVALID;
+        }
+        return sizeof(T);
+    }
+
+    static View view(char const* data) {
+        return load<T>(data);
+    }
+};
+
+/*
+ * \brief Strings, viewed as std::string_view into the encoded data
+ */
+template<>
+struct Traits<std::string> {
+    using View = std::string_view;
+    static constexpr size_t const FIXED_SIZE = 0;
+
+    static size_t encodedSize(std::string const& value) {
+        return sizeof(Length) + value.size();
+    }
+
+    static char* encode(std::string const& value, char* out) {
+        out = store(out, static_cast<Length>(value.size()));
+        std::memcpy(out, value.data(), value.size());
+        return out + value.size();
+    }
+
+    static size_t wireSize(char const* data) {
+        return sizeof(Length) + load<Length>(data);
+    }
+
+    static size_t validate(char const* data, size_t available) {
+        if (available < sizeof(Length) || available - sizeof(Length) < load<Length>(data)) {
+            return INVALID;
+        }
+        return wireSize(data);
+    }
+
+    static View view(char const* data) {
+        return View(data + sizeof(Length), load<Length>(data));
+    }
+};
+
+/*
+ * \brief Arrays, viewed as ArrayView into the encoded data
+ */
+template<typename T>
+struct Traits<std::vector<T>> {
+    using View = ArrayView<T>;
+    static constexpr size_t const FIXED_SIZE = 0;
+
+    static size_t encodedSize(std::vector<T> const& value) {
+        if constexpr (Traits<T>::FIXED_SIZE > 0) {
+            return sizeof(Length) + value.size() * Traits<T>::FIXED_SIZE;
+        } else {
+            size_t size = sizeof(Length) * (2 + value.size());
+            for (T const& element : value) {
+                size += Traits<T>::encodedSize(element);
+            }
+            return size;
+        }
+    }
+
+    static char* encode(std::vector<T> const& value, char* out) {
+        if constexpr (Traits<T>::FIXED_SIZE > 0) {
+            out = store(out, static_cast<Length>(value.size()));
+            for (T const& element : value) {
+                out = Traits<T>::encode(element, out);
+            }
+            return out;
+        } else {
+            char* table = store(out + sizeof(Length), static_cast<Length>(value.size()));
+            char* position = table + sizeof(Length) * value.size();
+            for (T const& element : value) {
+                table = store(table, static_cast<Length>(position - out));
+                position = Traits<T>::encode(element, position);
+            }
+            store(out, static_cast<Length>(position - out));
+            return position;
+        }
+    }
+
+    static size_t wireSize(char const* data) {
+        if constexpr (Traits<T>::FIXED_SIZE > 0) {
+            return sizeof(Length) + load<Length>(data) * Traits<T>::FIXED_SIZE;
+        } else {
+            return load<Length>(data);
+        }
+    }
+
+    static size_t validate(char const* data, size_t available) {
+        if constexpr (Traits<T>::FIXED_SIZE > 0) {
+            if (available < sizeof(Length) || (available - sizeof(Length)) / Traits<T>::FIXED_SIZE < load<Length>(data)) {
+                return INVALID;
+            }
+            size_t size = wireSize(data);
+            // Arrays of numbers only need the bounds check, everything else is validated per element
+            if (!std::is_arithmetic<T>::value || std::is_same<T, bool>::value) {
+                for (size_t position = sizeof(Length); position < size; position += Traits<T>::FIXED_SIZE) {
+                    if (Traits<T>::validate(data + position, Traits<T>::FIXED_SIZE) == INVALID) {
+                        return INVALID;
+                    }
+                }
+            }
+            return size;
+        } else {
+            if (available < 2 * sizeof(Length) || load<Length>(data) > available || load<Length>(data) < 2 * sizeof(Length)) {
+                return INVALID;
+            }
+            size_t size = load<Length>(data);
+            size_t count = load<Length>(data + sizeof(Length));
+            if (count > (size - 2 * sizeof(Length)) / sizeof(Length)) {
+                return INVALID;
+            }
+            bool valid = validateTable(data, size, data + 2 * sizeof(Length), count, [](size_t, char const* entry, size_t space) {
+                return Traits<T>::validate(entry, space);
+            });
+            return valid ? size : INVALID;
+        }
+    }
+
+    static View view(char const* data) {
+        return View(data);
+    }
+};
+
+/*
+ * \brief Encode a message directly into the outgoing buffer of the pipe
+ * \param pipe Pipe with write access, any BasicUnixPipe instantiation
+ * \param value Message to send, T is a message type generated by pipe-cxx-schemac
+ */
+template<typename T, typename Pipe>
+void write(Pipe& pipe, T const& value) {
+    pipe.writeWith(T::ID, Traits<T>::encodedSize(value), [&](char* out) {
+        Traits<T>::encode(value, out);
+    });
+}
+
+/*
+ * \brief Register a callback receiving an in-place view over the receive buffer for each message of type T
+ * \param pipe Pipe with read access, any BasicUnixPipe instantiation
+ * \param callback Callable taking Traits<T>::View, the view is only valid during the call
+ */
+template<typename T, typename Pipe, typename F>
+void subscribe(Pipe& pipe, F callback) {
+    pipe.addViewCallback(T::ID, [callback](std::string_view data) {
+        // Validate once, the accessors of the view rely on it
+        if (Traits<T>::validate(data.data(), data.size()) == data.size()) {
+            callback(Traits<T>::view(data.data()));
+        }
+    });
+}
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#ifdef __unix__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "MappedFile.hxx"
+
+/*
+ * \brief Counters of payload-free signals shared by the writers and the reader of a pipe
+ *
+ * The table lives in a file next to the pipe. Every signal identifier owns one of SLOTS slots,
+ * raising it increments the counter of the slot and sets its bit in the pending mask. Only
+ * the writer setting the first pending bit has to wake the reader, so any number of signals
+ * raised before the reader drained the table cost a single wakeup.
+ */
+class SignalTable {
+public:
+    // Number of signal identifiers of a pipe, one bit of the pending mask each
+    static constexpr size_t const SLOTS = 64;
+    // Maximum length of a signal identifier
+    static constexpr size_t const MAX_ID_LENGTH = 48;
+    // Identifies an initialized table file
+    static constexpr uint64_t const MAGIC = 0x4c414e4749534950;
+
+    /*
+     * \brief Attach to the table, the first process creates it
+     * \param path Path of the table file
+     */
+    explicit SignalTable(std::string const& path) : m_file(path, sizeof(Table)), m_table(reinterpret_cast<Table*>(m_file.data())) {
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared counters require lock-free 64 bit atomics.");
+        // The file is zero filled when created, the first process initializes it
+        uint64_t magic = 0;
+        if (m_table->magic.compare_exchange_strong(magic, 1)) {
+            m_table->magic.store(MAGIC, std::memory_order_release);
+        }
+        while (m_table->magic.load(std::memory_order_acquire) != MAGIC) {
+            std::this_thread::yield();
+        }
+    }
+
+    /*
+     * \brief Get the slot of a signal identifier, claimed on first use
+     * \param id Signal identifier
+     * \return Index of the slot
+     */
+    size_t slot(std::string_view id) {
+        if (id.empty() || id.size() > MAX_ID_LENGTH) {
+            throw std::logic_error("Signal identifiers have to be 1 to 48 characters long.");
+        }
+        for (size_t idx = 0; idx < SLOTS; ++idx) {
+            Slot& slot = m_table->slots[idx];
+            uint32_t state = slot.state.load(std::memory_order_acquire);
+            // Claim a free slot, the identifier is published with the ready state
+            if (state == Free && slot.state.compare_exchange_strong(state, Claiming, std::memory_order_acquire)) {
+                std::memcpy(slot.id, id.data(), id.size());
+                slot.length = static_cast<uint32_t>(id.size());
+                slot.state.store(Ready, std::memory_order_release);
+                return idx;
+            }
+            while (state == Claiming) {
+                std::this_thread::yield();
+                state = slot.state.load(std::memory_order_acquire);
+            }
+            if (std::string_view(slot.id, slot.length) == id) {
+                return idx;
+            }
+        }
+        throw std::logic_error("Tried to use more than 64 signal identifiers on a pipe.");
+    }
+
+    /*
+     * \brief Raise the signal of a slot
+     * \param slot Index of the slot
+     * \return True if no other signal was pending and the reader has to be woken
+     */
+    bool raise(size_t slot) {
+        m_table->slots[slot].count.fetch_add(1, std::memory_order_relaxed);
+        // Release the counter with the bit, the reader exchanges the mask before the counters
+        return m_table->pending.fetch_or(uint64_t(1) << slot, std::memory_order_acq_rel) == 0;
+    }
+
+    /*
+     * \brief Take all pending signals, only called by the reader
+     * \param handler Callable taking the slot index and the number of signals raised since the last drain
+     */
+    template<typename Handler>
+    void drain(Handler&& handler) {
+        uint64_t pending = m_table->pending.exchange(0, std::memory_order_acq_rel);
+        while (pending != 0) {
+            size_t idx = __builtin_ctzll(pending);
+            pending &= pending - 1;
+            // A signal raised after the mask was taken is counted here and set its bit again, it then drains as 0
+            uint64_t count = m_table->slots[idx].count.exchange(0, std::memory_order_acquire);
+            if (count > 0) {
+                handler(idx, count);
+            }
+        }
+    }
+
+private:
+    // States of a slot
+    enum : uint32_t { Free = 0, Claiming = 1, Ready = 2 };
+
+    /*
+     * \brief Counter of one signal identifier, one cache line
+     */
+    struct alignas(64) Slot {
+        // Signals raised since the reader drained the slot
+        std::atomic<uint64_t> count;
+        // Free, Claiming or Ready
+        std::atomic<uint32_t> state;
+        // Length of the identifier
+        uint32_t length;
+        // Identifier, valid once the slot is ready
+        char id[MAX_ID_LENGTH];
+    };
+
+    /*
+     * \brief Layout of the table file
+     */
+    struct Table {
+        // MAGIC once initialized
+        std::atomic<uint64_t> magic;
+        // Bit per slot with raised signals
+        alignas(64) std::atomic<uint64_t> pending;
+        // Counters
+        Slot slots[SLOTS];
+    };
+
+    // Mapped table file
+    MappedFile m_file;
+    // Table in the mapped file
+    Table* m_table;
+};
+
+#endif
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/*
+ * \brief Allocator of short-lived blocks with power of two size classes
+ *
+ * Blocks are carved out of slabs that are only freed with the allocator and recycled through
+ * one lock-free free list (Treiber stack) per size class, so any thread may allocate and
+ * release blocks and steady-state operation never calls the global allocator. The mutex is
+ * only taken to add a slab when a free list runs empty. Blocks larger than the largest class
+ * are allocated individually. All blocks have to be released before the allocator is destroyed.
+ */
+class SlabAllocator {
+public:
+    // Block size of the smallest class is 2^MIN_CLASS_BITS bytes including the block header
+    static constexpr size_t const MIN_CLASS_BITS = 6;
+    // Number of size classes, the largest block has 2^(MIN_CLASS_BITS + SIZE_CLASSES - 1) bytes
+    static constexpr size_t const SIZE_CLASSES = 15;
+    // Minimum number of bytes allocated at once to refill a free list
+    static constexpr size_t const SLAB_SIZE = 64 * 1024;
+
+    SlabAllocator() : m_reserved(0), m_fallbacks(0) {
+        for (std::atomic<uint64_t>& head : m_free) {
+            head.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    SlabAllocator(SlabAllocator const&) = delete;
+    SlabAllocator& operator=(SlabAllocator const&) = delete;
+
+    ~SlabAllocator() {
+        for (void* slab : m_slabs) {
+            std::free(slab);
+        }
+    }
+
+    /*
+     * \brief Allocate a block, aligned like malloc
+     * \param size Usable size of the block
+     */
+    void* allocate(size_t size) {
+        size_t sizeClass = classOf(size + sizeof(Block));
+        Block* block;
+        if (sizeClass >= SIZE_CLASSES) {
+            block = static_cast<Block*>(std::malloc(size + sizeof(Block)));
+            if (block == nullptr) {
+                throw std::bad_alloc();
+            }
+            m_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            block = pop(sizeClass);
+            if (block == nullptr) {
+                block = refill(sizeClass);
+            }
+        }
+        block->sizeClass = static_cast<uint32_t>(sizeClass);
+        return block + 1;
+    }
+
+    /*
+     * \brief Recycle a block returned by allocate()
+     */
+    void deallocate(void* ptr) {
+        Block* block = static_cast<Block*>(ptr) - 1;
+        if (block->sizeClass >= SIZE_CLASSES) {
+            std::free(block);
+        } else {
+            push(block->sizeClass, block, block);
+        }
+    }
+
+    /*
+     * \brief Get the number of bytes held in slabs
+     */
+    size_t reserved() const {
+        return m_reserved.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * \brief Get the number of allocations too large for any size class, served by the global allocator
+     */
+    size_t fallbacks() const {
+        return m_fallbacks.load(std::memory_order_relaxed);
+    }
+
+private:
+    /*
+     * \brief Header in front of every block
+     */
+    struct alignas(16) Block {
+        // Next free block of the same class, only meaningful while the block is free
+        std::atomic<Block*> next;
+        // Size class of the block
+        uint32_t sizeClass;
+    };
+
+    // Bits of a free list head holding the pointer, user space addresses fit into 48 bits
+    static constexpr unsigned const POINTER_BITS = 48;
+    static constexpr uint64_t const POINTER_MASK = (uint64_t(1) << POINTER_BITS) - 1;
+
+    // Free list heads, the pointer is tagged with a counter in the upper bits against ABA
+    std::atomic<uint64_t> m_free[SIZE_CLASSES];
+    // Guards adding slabs
+    std::mutex m_mutex;
+    // All slabs, freed with the allocator
+    std::vector<void*> m_slabs;
+    // Number of bytes held in slabs
+    std::atomic<size_t> m_reserved;
+    // Number of allocations served by the global allocator
+    std::atomic<size_t> m_fallbacks;
+
+    /*
+     * \brief Get the smallest class whose blocks hold the given number of bytes
+     */
+    static size_t classOf(size_t bytes) {
+        size_t sizeClass = 0;
+        while (sizeClass < SIZE_CLASSES && (size_t(1) << (MIN_CLASS_BITS + sizeClass)) < bytes) {
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+
+    static Block* pointerOf(uint64_t head) {
+        return reinterpret_cast<Block*>(static_cast<uintptr_t>(head & POINTER_MASK));
+    }
+
+    static uint64_t tagged(Block* block, uint64_t previous) {
+        return ((previous >> POINTER_BITS) + 1) << POINTER_BITS | static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block));
+    }
+
+    /*
+     * \brief Take a block from the free list of a class
+     * \return Block or nullptr if the list is empty
+     */
+    Block* pop(size_t sizeClass) {
+        uint64_t head = m_free[sizeClass].load(std::memory_order_acquire);
+        while (Block* block = pointerOf(head)) {
+            // Blocks are never unmapped, a stale block is only read and the tag fails the exchange
+            Block* next = block->next.load(std::memory_order_relaxed);
+            if (m_free[sizeClass].compare_exchange_weak(head, tagged(next, head), std::memory_order_acquire, std::memory_order_acquire)) {
+                return block;
+            }
+        }
+        return nullptr;
+    }
+
+    /*
+     * \brief Put a chain of linked blocks onto the free list of a class
+     * \param first First block of the chain
+     * \param last Last block of the chain
+     */
+    void push(size_t sizeClass, Block* first, Block* last) {
+        uint64_t head = m_free[sizeClass].load(std::memory_order_relaxed);
+        do {
+            last->next.store(pointerOf(head), std::memory_order_relaxed);
+        } while (!m_free[sizeClass].compare_exchange_weak(head, tagged(first, head), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /*
+     * \brief Carve a new slab into blocks of a class
+     * \return One of the blocks, the others are put onto the free list
+     */
+    Block* refill(size_t sizeClass) {
+        size_t blockSize = size_t(1) << (MIN_CLASS_BITS + sizeClass);
+        size_t count = SLAB_SIZE > blockSize ? SLAB_SIZE / blockSize : 1;
+        char* slab = static_cast<char*>(std::malloc(count * blockSize));
+        if (slab == nullptr) {
+            throw std::bad_alloc();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slabs.push_back(slab);
+        }
+        m_reserved.fetch_add(count * blockSize, std::memory_order_relaxed);
+        Block* first = reinterpret_cast<Block*>(slab);
+        for (size_t idx = 0; idx < count; ++idx) {
+            Block* block = new (slab + idx * blockSize) Block();
+            block->sizeClass = static_cast<uint32_t>(sizeClass);
+            block->next.store(idx + 1 < count ? reinterpret_cast<Block*>(slab + (idx + 1) * blockSize) : nullptr, std::memory_order_relaxed);
+        }
+        if (count > 1) {
+            push(sizeClass, reinterpret_cast<Block*>(slab + blockSize), reinterpret_cast<Block*>(slab + (count - 1) * blockSize));
+        }
+        return first;
+    }
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * \brief Bloom filter over message identifiers, identical in all processes
+ */
+class BloomFilter {
+public:
+    /*
+     * \brief Create an empty filter sized for the given number of identifiers
+     * \param count Number of identifiers to insert
+     * \param falsePositiveRate Target probability that an identifier not inserted matches
+     */
+    BloomFilter(size_t count, double falsePositiveRate) {
+        // Optimal size m = -n ln(p) / ln(2)^2 and number of hashes k = m / n ln(2)
+        double bits = std::ceil(-static_cast<double>(std::max<size_t>(count, 1)) * std::log(falsePositiveRate) / (std::log(2.0) * std::log(2.0)));
+        m_words.assign((static_cast<size_t>(bits) + 63) / 64, 0);
+        m_hashes = std::max<size_t>(1, static_cast<size_t>(std::round(m_words.size() * 64.0 / std::max<size_t>(count, 1) * std::log(2.0))));
+    }
+
+    /*
+     * \brief Create a filter from its serialized bits
+     * \param hashes Number of hash functions
+     * \param words Bits of the filter
+     */
+    BloomFilter(size_t hashes, std::vector<uint64_t> words) : m_words(std::move(words)), m_hashes(hashes) {}
+
+    /*
+     * \brief Insert an identifier
+     */
+    void insert(std::string_view id) {
+        uint64_t hash = hashOf(id);
+        for (size_t idx = 0; idx < m_hashes; ++idx) {
+            size_t bit = position(hash, idx);
+            m_words[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    /*
+     * \brief Check if an identifier may have been inserted, false positives are possible
+     */
+    bool mayContain(std::string_view id) const {
+        uint64_t hash = hashOf(id);
+        for (size_t idx = 0; idx < m_hashes; ++idx) {
+            size_t bit = position(hash, idx);
+            if ((m_words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * \brief Get the number of hash functions
+     */
+    size_t hashes() const {
+        return m_hashes;
+    }
+
+    /*
+     * \brief Get the bits of the filter
+     */
+    std::vector<uint64_t> const& words() const {
+        return m_words;
+    }
+
+private:
+    // Bits of the filter
+    std::vector<uint64_t> m_words;
+    // Number of hash functions
+    size_t m_hashes;
+
+    /*
+     * \brief 64 bit FNV-1a hash with a final mix, defined independent of the standard library so writer and reader agree
+     */
+    static uint64_t hashOf(std::string_view id) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char ch : id) {
+            hash = (hash ^ static_cast<uint8_t>(ch)) * 0x100000001b3ull;
+        }
+        // FNV spreads short identifiers badly over the high bits used by double hashing
+        hash = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccdull;
+        hash = (hash ^ (hash >> 33)) * 0xc4ceb9fe1a85ec53ull;
+        return hash ^ (hash >> 33);
+    }
+
+    /*
+     * \brief Bit of the given hash function, derived by double hashing
+     */
+    size_t position(uint64_t hash, size_t idx) const {
+        uint64_t second = (hash >> 32) | 1;
+        return static_cast<size_t>((hash + idx * second) % (m_words.size() * 64));
+    }
+};
+
+/*
+ * \brief Set of identifiers a reader subscribed to, advertised to the writer over the control pipe
+ *
+ * Up to a configurable number of identifiers the set is sent exactly, beyond that as Bloom
+ * filter whose false positives only cost sending a message the reader discards.
+ */
+class SubscriptionFilter {
+public:
+    // Target false positive rate of Bloom filters
+    static constexpr double const FALSE_POSITIVE_RATE = 0.01;
+    // Maximum number of hash functions accepted from a reader
+    static constexpr size_t const MAX_HASHES = 32;
+
+    /*
+     * \brief Serialize the subscribed identifiers
+     * \param ids Subscribed identifiers
+     * \param maxExact Maximum number of identifiers sent exactly
+     */
+    static std::string encode(std::set<std::string> const& ids, size_t maxExact) {
+        std::string out;
+        if (ids.size() <= maxExact) {
+            out += 'E';
+            for (std::string const& id : ids) {
+                out += std::to_string(id.size()) + ":" + id;
+            }
+            return out;
+        }
+        BloomFilter bloom(ids.size(), FALSE_POSITIVE_RATE);
+        for (std::string const& id : ids) {
+            bloom.insert(id);
+        }
+        out += 'B' + std::to_string(bloom.hashes()) + ":";
+        out.append(reinterpret_cast<char const*>(bloom.words().data()), bloom.words().size() * sizeof(uint64_t));
+        return out;
+    }
+
+    /*
+     * \brief Parse serialized identifiers, a malformed or empty message matches all identifiers
+     * \param msg Message created by encode()
+     */
+    explicit SubscriptionFilter(std::string_view msg) : m_all(true) {
+        if (!msg.empty() && msg[0] == 'E') {
+            m_all = false;
+            size_t pos = 1;
+            while (pos < msg.size()) {
+                size_t sep = msg.find(':', pos);
+                size_t length = sep == std::string_view::npos ? 0 : std::strtoull(std::string(msg.substr(pos, sep - pos)).c_str(), nullptr, 10);
+                if (sep == std::string_view::npos || length > msg.size() - sep - 1) {
+                    m_all = true;
+                    return;
+                }
+                m_exact.emplace(msg.substr(sep + 1, length));
+                pos = sep + 1 + length;
+            }
+        } else if (!msg.empty() && msg[0] == 'B') {
+            size_t sep = msg.find(':');
+            size_t hashes = sep == std::string_view::npos ? 0 : std::strtoull(std::string(msg.substr(1, sep - 1)).c_str(), nullptr, 10);
+            size_t bytes = sep == std::string_view::npos ? 0 : msg.size() - sep - 1;
+            if (hashes == 0 || hashes > MAX_HASHES || bytes == 0 || bytes % sizeof(uint64_t) != 0) {
+                return;
+            }
+            std::vector<uint64_t> words(bytes / sizeof(uint64_t));
+            std::memcpy(words.data(), msg.data() + sep + 1, bytes);
+            m_bloom.reset(new BloomFilter(hashes, std::move(words)));
+            m_all = false;
+        }
+    }
+
+    /*
+     * \brief Check if messages of an identifier have to be sent
+     */
+    bool matches(std::string_view id) const {
+        if (m_all) {
+            return true;
+        }
+        return m_bloom ? m_bloom->mayContain(id) : m_exact.find(id) != m_exact.end();
+    }
+
+private:
+    // True if all identifiers match
+    bool m_all;
+    // Exactly advertised identifiers
+    std::set<std::string, std::less<>> m_exact;
+    // Advertised Bloom filter, used instead of the exact identifiers if set
+    std::unique_ptr<BloomFilter> m_bloom;
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/*
+ * \brief Hierarchical timing wheel (Varghese and Lauck) holding values until their deadline tick
+ *
+ * Each level has SLOTS slots, a slot of level L spans SLOTS^L ticks. A value is inserted
+ * into the lowest level whose range still contains its deadline and moves down one level
+ * whenever the wheel reaches the start of its slot, so inserting and firing cost O(1) per
+ * value independent of the number of scheduled values. Advancing skips ticks without values
+ * and an empty wheel moves to the current tick when a value is scheduled, so idle time costs
+ * nothing. Values with the same deadline fire in insertion order. Not thread safe.
+ */
+template<typename T>
+class TimerWheel {
+public:
+    // Number of bits of the tick selecting the slot on each level
+    static constexpr size_t const SLOT_BITS = 8;
+    // Number of slots per level
+    static constexpr size_t const SLOTS = size_t(1) << SLOT_BITS;
+    // Number of levels, deadlines beyond SLOTS^LEVELS ticks wait in an overflow list
+    static constexpr size_t const LEVELS = 4;
+    // Returned by nextExpiry() if nothing is scheduled
+    static constexpr uint64_t const NEVER = std::numeric_limits<uint64_t>::max();
+
+    /*
+     * \brief Create an empty wheel
+     * \param now Current tick, deadlines are absolute ticks on the same scale
+     */
+    explicit TimerWheel(uint64_t now) : m_current(now), m_size(0) {
+        m_slots.resize(LEVELS * SLOTS);
+    }
+
+    /*
+     * \brief Schedule a value
+     * \param deadline Tick at which the value fires, past deadlines fire with the next tick
+     * \param value Value to hand out when firing
+     * \param now Current tick, an empty wheel moves to it so the value is placed relative to it
+     */
+    void schedule(uint64_t deadline, T value, uint64_t now) {
+        if (m_size == 0 && now > m_current) {
+            m_current = now;
+        }
+        insert(Entry{ std::max(deadline, m_current + 1), std::move(value) });
+        ++m_size;
+    }
+
+    /*
+     * \brief Advance the wheel and fire all values whose deadline passed, ordered by deadline
+     * \param now Current tick
+     * \param fire Callable taking each fired value
+     */
+    template<typename Fire>
+    void advance(uint64_t now, Fire&& fire) {
+        while (m_current < now) {
+            // Jump to the next tick with values to fire or move down
+            uint64_t next = nextExpiry();
+            if (next > now) {
+                m_current = now;
+                break;
+            }
+            m_current = next;
+            // Move values of the slot starting now on higher levels down, highest level first
+            if ((m_current & (SLOTS - 1)) == 0) {
+                cascade();
+            }
+            std::vector<Entry>& slot = m_slots[m_current & (SLOTS - 1)];
+            if (slot.empty()) {
+                continue;
+            }
+            std::vector<Entry> due;
+            due.swap(slot);
+            m_size -= due.size();
+            for (Entry& entry : due) {
+                fire(std::move(entry.value));
+            }
+        }
+    }
+
+    /*
+     * \brief Get the next tick at which advance() fires or moves values, NEVER if empty
+     *
+     * Values on higher levels report the start of their slot, at which they move down, so a
+     * caller sleeping until the returned tick wakes up at most once per level for far deadlines.
+     */
+    uint64_t nextExpiry() const {
+        if (m_size == 0) {
+            return NEVER;
+        }
+        // A level only holds deadlines of the current round of the level above, lower levels are due first
+        for (size_t level = 0; level < LEVELS; ++level) {
+            size_t shift = SLOT_BITS * level;
+            uint64_t round = m_current >> (shift + SLOT_BITS) << (shift + SLOT_BITS);
+            for (uint64_t slot = ((m_current >> shift) & (SLOTS - 1)) + 1; slot < SLOTS; ++slot) {
+                if (!m_slots[level * SLOTS + slot].empty()) {
+                    return round + (slot << shift);
+                }
+            }
+        }
+        // Only overflowing values left, they move down at the start of the next round of the highest level
+        return ((m_current >> (SLOT_BITS * LEVELS)) + 1) << (SLOT_BITS * LEVELS);
+    }
+
+    /*
+     * \brief Get the number of scheduled values
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+    /*
+     * \brief Get the tick the wheel advanced to
+     */
+    uint64_t now() const {
+        return m_current;
+    }
+
+private:
+    /*
+     * \brief Scheduled value with its deadline
+     */
+    struct Entry {
+        uint64_t deadline;
+        T value;
+    };
+
+    // Slots of all levels, level L starts at index L * SLOTS
+    std::vector<std::vector<Entry>> m_slots;
+    // Values with deadlines beyond the range of the highest level
+    std::vector<Entry> m_overflow;
+    // Tick the wheel advanced to, all values up to it fired
+    uint64_t m_current;
+    // Number of scheduled values
+    size_t m_size;
+
+    /*
+     * \brief Put an entry into the lowest level covering its deadline
+     */
+    void insert(Entry entry) {
+        // The highest group of bits in which deadline and current tick differ selects the level
+        uint64_t differing = entry.deadline ^ m_current;
+        for (size_t level = 0; level < LEVELS; ++level) {
+            if ((differing >> (SLOT_BITS * (level + 1))) == 0) {
+                size_t slot = (entry.deadline >> (SLOT_BITS * level)) & (SLOTS - 1);
+                m_slots[level * SLOTS + slot].push_back(std::move(entry));
+                return;
+            }
+        }
+        m_overflow.push_back(std::move(entry));
+    }
+
+    /*
+     * \brief Redistribute the slots of higher levels that start at the current tick
+     */
+    void cascade() {
+        // Find the highest level whose slot boundary is reached
+        size_t top = 1;
+        while (top < LEVELS && ((m_current >> (SLOT_BITS * top)) & (SLOTS - 1)) == 0) {
+            ++top;
+        }
+        std::vector<Entry> moved;
+        if (top == LEVELS) {
+            moved.swap(m_overflow);
+        }
+        // Entries of a higher level were scheduled before entries of the same deadline on lower levels
+        for (size_t level = std::min(top, LEVELS - 1); level >= 1; --level) {
+            std::vector<Entry>& slot = m_slots[level * SLOTS + ((m_current >> (SLOT_BITS * level)) & (SLOTS - 1))];
+            for (Entry& entry : slot) {
+                moved.push_back(std::move(entry));
+            }
+            slot.clear();
+        }
+        for (Entry& entry : moved) {
+            insert(std::move(entry));
+        }
+    }
+};
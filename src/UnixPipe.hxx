@@ -5,15 +5,39 @@
 #include <iostream>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <vector>
 #include <cstring>
 #include <thread>
 #include <map>
+#include <set>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "BufferPool.hxx"
+#include "Executor.hxx"
+#include "FrameSizeHistogram.hxx"
+#include "IdStatistics.hxx"
+#include "InlineFunction.hxx"
+#include "LocalChannel.hxx"
+#include "MemoryGovernor.hxx"
+#include "PipeCodec.hxx"
+#include "PipeConfig.hxx"
+#include "PipePolicies.hxx"
+#include "PipeTransport.hxx"
+#include "SignalTable.hxx"
+#include "SubscriptionFilter.hxx"
+#include "TimerWheel.hxx"
 
 /**
  * \brief Pipe access type, either read or write
@@ -25,52 +49,183 @@ enum class PipeAccess {
 
 /*
  * \brief Class to transmit/receive messages over a named pipe
+ *
+ * The policies select at compile time what the hot paths do, UnixPipe uses the defaults:
+ * \tparam Framing Codec of the frames, PipeCodec escapes tags, RawCodec sends them as they are
+ * \tparam Buffer Receive buffer sizing, AdaptiveBuffer follows the frame sizes, FixedBuffer grows by PipeConfig::readSize
+ * \tparam Locking Serialization of writers, MutexLocking or NoLocking for a single writing thread without background writers
+ * \tparam Instrumentation Traffic counters, IdInstrumentation once enabled or NoInstrumentation
  */
-class UnixPipe {
+template<typename Framing = PipeCodec, typename Buffer = AdaptiveBuffer, typename Locking = MutexLocking, typename Instrumentation = IdInstrumentation>
+class BasicUnixPipe {
 public:
-    // Initial (and incremental) buffer size for incoming data
+    // Default initial (and incremental) buffer size for incoming data, see PipeConfig::readSize
     static size_t const INITIAL_BUFFER_SIZE = 8096;
+    // An empty receive buffer is shrunk once it is this many times larger than the adapted size
+    static constexpr size_t const SHRINK_FACTOR = 2;
+    // Timeout in milliseconds after which the reader thread checks for stop requests
+    static int const POLL_TIMEOUT_MS = 100;
     // Prefix attached to each message to check for start
-    constexpr static const char* const PREFIX = "NAMEDPIPE";
-    constexpr static const char* const START = "START";
-    constexpr static const char* const END = "END";
+    constexpr static const char* const PREFIX = PipeCodec::PREFIX;
+    constexpr static const char* const START = PipeCodec::START;
+    constexpr static const char* const END = PipeCodec::END;
+    // Size of the reader stack locked into memory in latency mode
+    static constexpr size_t const LOCKED_STACK_SIZE = 64 * 1024;
+    // Maximum size of a callable registered as callback
+    static constexpr size_t const CALLBACK_CAPACITY = 64;
+    // Suffix of the lock file of the writers listening for requests of readers, each one reads its own control pipe NAME.ctl.<slot>
+    constexpr static const char* const CONTROL_SUFFIX = ".ctl";
+    // Maximum number of writers of a pipe listening for requests of readers at the same time
+    static constexpr size_t const MAX_LISTENERS = 64;
+    // Prefix of the identifiers of internal messages, writing a message whose identifier starts with it is rejected
+    constexpr static const char* const RESERVED_PREFIX = "__pipe.";
+    // Control message of a reader asking for the retained messages
+    constexpr static const char* const SNAPSHOT_REQUEST = "__pipe.snapshot_request";
+    // Messages enclosing the replayed retained messages, a callback for SNAPSHOT_END is called once the snapshot is complete
+    constexpr static const char* const SNAPSHOT_BEGIN = "__pipe.snapshot_begin";
+    constexpr static const char* const SNAPSHOT_END = "__pipe.snapshot_end";
+    // Default time in milliseconds a reader waits for a requested snapshot before it accepts live messages
+    static constexpr int const SNAPSHOT_TIMEOUT_MS = 1000;
+    // Control message of a reader advertising the identifiers it has callbacks for, empty to receive all
+    constexpr static const char* const SUBSCRIBE = "__pipe.subscribe";
+    // Delivered to the callback of a pipe watching for hangup once all its writers left, e.g. the readers sending control messages
+    constexpr static const char* const HANGUP = "__pipe.hangup";
+    // Suffix of the file holding the signal counters of the pipe
+    constexpr static const char* const SIGNAL_SUFFIX = ".sig";
+    // Message waking the reader to drain the signal counters, sent by the writer raising the first pending signal
+    constexpr static const char* const SIGNAL = "__pipe.signal";
+    // Default number of identifiers advertised exactly, more are advertised as Bloom filter
+    static constexpr size_t const EXACT_SUBSCRIPTIONS = 64;
+    // Number of reader rounds with in-process messages after which the named pipe is read again
+    static constexpr size_t const LOCAL_FIFO_CHECK = 64;
+    // Time in milliseconds a reader paused by the MemoryGovernor waits before checking again
+    static constexpr int const PAUSE_CHECK_MS = 10;
+    // Resolution of scheduled writes in microseconds, messages are never written before their time
+    static constexpr int64_t const SCHEDULE_TICK_US = 1000;
+    // Time in milliseconds a closing writer waits for room for its coalesced frames, e.g. while no reader listens on a socket
+    static constexpr int const CLOSE_TIMEOUT_MS = 1000;
+
+    // Callback called for each received message of an identifier, stored inline without heap allocation
+    using Callback = InlineFunction<void(std::string const&), CALLBACK_CAPACITY>;
+    // Callback called with a view of the message content in the receive buffer, only valid during the call
+    using ViewCallback = InlineFunction<void(std::string_view), CALLBACK_CAPACITY>;
+    // Callback called with the number of signals of an identifier raised since its last call
+    using SignalCallback = InlineFunction<void(uint64_t), CALLBACK_CAPACITY>;
 
     /*
      * \brief Create a read or write named pipe
      * \param name Name of the pipe file (path)
      * \param access Access type, either read or write
+     * \param config Tuning parameters, loaded from PIPE_CXX_CONFIG by default
      */
-    UnixPipe(std::string const name, PipeAccess access) : m_name(name), m_access(access), m_fd(-1), m_hasToStop(false), m_reader() {
-        struct stat st;
-        // Check if pipe exists
-        if (stat(name.c_str(), &st) == 0) {
-            // Check if given name/path is a valid named pipe
-            if (!S_ISFIFO(st.st_mode)) {
-                std::cerr << name << " is not a named pipe." << std::endl;
-            }
+    BasicUnixPipe(std::string const name, PipeAccess access, PipeConfig const config = PipeConfig::fromEnvironment())
+        : m_name(name), m_access(access), m_config(config), m_hasToStop(false), m_bufferSize(0), m_reader(),
+          m_filled(0), m_baseSize(config.readSize), m_growStep(config.readSize),
+          m_deficitBytes(SIZE_MAX), m_deficitMessages(SIZE_MAX), m_ready(false) {
+        if (m_config.transport == TransportType::Memory) {
+            m_transport.reset(new MemoryTransport(name, m_config.capacity));
+        } else if (m_config.transport == TransportType::SeqPacket) {
+            m_transport.reset(new SeqPacketTransport(name, m_access == PipeAccess::Read, m_config.capacity));
+        } else {
+            m_transport.reset(new FifoTransport(name, m_config.capacity));
+        }
+        // Packet transports fetch a batch of packets into slots of the receive buffer
+        m_baseSize = std::max(m_baseSize, m_transport->batchSize());
+        // Readers account their buffers with the process-wide memory budget, only writers carry the state of writing
+        if (m_access == PipeAccess::Read) {
+            m_account = MemoryGovernor::instance().attach();
         } else {
-            // Create new named pipe
-            if (mkfifo(name.c_str(), 0666) == -1) {
-                perror("mkfifo");
-                abort();
+            m_writer.reset(new WriterState());
+        }
+        // Writers and the reader of the same named pipe in this process exchange messages in memory
+        if (m_config.localShortcut && m_config.transport != TransportType::Memory) {
+            m_local = LocalChannel::attach(name);
+            if (m_access == PipeAccess::Read) {
+                m_local->setReader(true);
             }
         }
-        // Open named pipe, use O_RDWR to prevent SIGPIPE on exit of reader
-        // Use O_NONBLOCK for writer to prevent blocking on open call
-        m_fd = open(name.c_str(), (access == PipeAccess::Write) ? O_RDWR | O_NONBLOCK : O_RDWR);
+        // Latency mode: pre-fault (and lock) the send buffer so coalescing never touches fresh pages
+        if (m_access == PipeAccess::Write && m_config.prefaultSize > 0) {
+            m_writer->output.resize(m_config.prefaultSize, '\0');
+            m_writer->output.clear();
+            lockBuffer(m_writer->output);
+        }
     }
 
     /*
      * \brief Delete pipe by closing file descriptor and stopping reader thread if active
      */
-    ~UnixPipe() {
+    ~BasicUnixPipe() {
+        // Stop serving the pipe from a reactor thread
+        if (m_detach) {
+            Detach detach = std::move(m_detach);
+            detach();
+        }
+        // Stop the scheduler thread, scheduled messages not yet due are dropped
+        if (m_writer && m_writer->scheduler && m_writer->scheduler->joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_writer->scheduleMutex);
+                m_hasToStop = true;
+            }
+            m_writer->scheduleChanged.notify_one();
+            m_writer->scheduler->join();
+        }
+        if (m_features) {
+            // Writers send all messages again once the advertising reader is gone
+            if (m_features->advertise) {
+                for (auto const& control : m_features->controls) {
+                    control->writeMessage(SUBSCRIBE, "");
+                    control->flush();
+                }
+            }
+            m_features->controls.clear();
+        }
+        if (m_writer) {
+            // Stop serving snapshot requests before the pipe is closed
+            m_writer->control.reset();
+            if (m_writer->controlLock != -1) {
+                close(m_writer->controlLock);
+            }
+            // Write pending coalesced frames, without waiting forever for a reader that never makes room
+            try {
+                std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+                std::string& output = m_writer->output;
+                if (!output.empty() && !writeAll(output.data(), output.length(), CLOSE_TIMEOUT_MS)) {
+                    std::cerr << "Dropped coalesced frames of " << m_name << ", no reader made room." << std::endl;
+                }
+                output.clear();
+            } catch (std::logic_error& ex) {
+                std::cerr << ex.what() << std::endl;
+            }
+        }
         // If reader thread is running, stop it
         if (m_reader && m_reader->joinable()) {
             m_hasToStop = true;
             m_reader->join();
         }
-        // Close file descriptor
-        close(m_fd);
+        // Executors stop running callbacks of the pipe
+        if (m_features) {
+            for (auto const& inbox : m_features->inboxes) {
+                inbox.first->detach(inbox.second);
+            }
+        }
+        // Writers of this process fall back to the named pipe
+        if (m_local && m_access == PipeAccess::Read) {
+            m_local->setReader(false);
+        }
+        // Release locked send buffer
+        if (m_writer) {
+            unlockBuffer(m_writer->output);
+        }
+        // Other pipes of the process reuse the receive buffer
+        if (m_config.prefaultSize == 0 && !m_input.empty()) {
+            BufferPool::instance().release(std::move(m_input));
+        }
+        if (m_account) {
+            MemoryGovernor::instance().detach(m_account);
+        }
+        // Close the named pipe
+        m_transport.reset();
     }
 
     /*
@@ -81,217 +236,1538 @@ public:
         if (m_access != PipeAccess::Read) {
             throw std::logic_error("Tried to call start on pipe with write access only.");
         }
+        if (m_detach) {
+            throw std::logic_error("Tried to start a pipe served by a reactor.");
+        }
         // Start read thread if missing
         if (!m_reader) {
-            m_reader.reset(new std::thread(std::bind(&UnixPipe::handleRead, this)));
+            announce();
+            m_reader.reset(new std::thread(std::bind(&BasicUnixPipe::handleRead, this)));
         }
     }
 
     /*
      * \brief Add callback for a given message identifier
      * \param id Message identifier to use for the callback
-     * \param callback Callback to call for the message identifier
+     * \param callback Callback to call for the message identifier, any callable up to CALLBACK_CAPACITY bytes
+     */
+    void addCallback(std::string const id, Callback callback) {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to call start on pipe with write access only.");
+        }
+        // Check if callback already present
+        if (hasCallback(id)) {
+            throw std::logic_error("Tried to add a second callback for the same identifier.");
+        }
+        // Set callback
+        m_callbacks.emplace(id, std::move(callback));
+    }
+
+    /*
+     * \brief Add callback receiving the message content in place, without copying it out of the receive buffer
+     * \param id Message identifier to use for the callback
+     * \param callback Callback to call for the message identifier, the view is only valid during the call
      */
-    void addCallback(std::string const id, std::function<void(std::string const&)> callback) {
+    void addViewCallback(std::string const id, ViewCallback callback) {
         // Check if read access
         if (m_access != PipeAccess::Read) {
             throw std::logic_error("Tried to call start on pipe with write access only.");
         }
         // Check if callback already present
-        if (m_callbacks.find(id) != m_callbacks.end()) {
+        if (hasCallback(id)) {
             throw std::logic_error("Tried to add a second callback for the same identifier.");
         }
         // Set callback
-        m_callbacks[id] = callback;
+        m_viewCallbacks.emplace(id, std::move(callback));
+    }
+
+    /*
+     * \brief Add callback running on an executor instead of the reader thread
+     *
+     * The reader copies matching messages into the inbox of the pipe on the executor, messages
+     * of the same pipe run on the executor in the order they were received.
+     * \param id Message identifier to use for the callback
+     * \param executor Executor running the callback, has to outlive the pipe
+     * \param callback Callback to call for the message identifier, the view is only valid during the call
+     */
+    void addCallback(std::string const id, Executor& executor, ViewCallback callback) {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to call start on pipe with write access only.");
+        }
+        // Check if callback already present
+        if (hasCallback(id)) {
+            throw std::logic_error("Tried to add a second callback for the same identifier.");
+        }
+        std::shared_ptr<Executor::Inbox>& inbox = features().inboxes[&executor];
+        if (!inbox) {
+            inbox = executor.attach();
+        }
+        features().executorCallbacks.emplace(id, ExecutorCallback{ std::move(callback), inbox.get() });
+    }
+
+    /*
+     * \brief Add callback for a payload-free signal raised by writers with signal()
+     * \param id Signal identifier, at most SignalTable::MAX_ID_LENGTH characters
+     * \param callback Callback to call with the number of signals raised since its last call
+     */
+    void addSignalCallback(std::string const id, SignalCallback callback) {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to call addSignalCallback on pipe with write access only.");
+        }
+        size_t slot = signalTable().slot(id);
+        std::map<size_t, SignalCallback>& callbacks = features().signalCallbacks;
+        if (callbacks.find(slot) != callbacks.end()) {
+            throw std::logic_error("Tried to add a second callback for the same identifier.");
+        }
+        callbacks.emplace(slot, std::move(callback));
+    }
+
+    /*
+     * \brief Retain the last messages of an identifier and replay them to each reader requesting a snapshot
+     * \param id Message identifier to retain
+     * \param depth Number of retained messages, 1 keeps the last value
+     */
+    void retain(std::string const id, size_t depth = 1) {
+        // Snapshots are written by the control thread
+        static_assert(Locking::CONCURRENT, "Retaining messages needs a Locking policy serializing writers of several threads.");
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call retain on pipe with read access only.");
+        }
+        {
+            std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+            Retention& retention = m_writer->retained[id];
+            retention.depth = std::max<size_t>(depth, 1);
+            while (retention.frames.size() > retention.depth) {
+                retention.frames.pop_front();
+            }
+        }
+        // Listen for snapshot requests of readers
+        listenControl();
+    }
+
+    /*
+     * \brief Skip messages of identifiers the reader has no callback for, has to be called before the first write
+     *
+     * Only takes effect once the reader advertised its identifiers with advertiseSubscriptions(),
+     * until then and after that reader is gone all messages are sent. Retained identifiers are always sent.
+     */
+    void filterSubscriptions() {
+        // The control thread updates the filter and answers requests while the writer writes
+        static_assert(Locking::CONCURRENT, "Filtering subscriptions needs a Locking policy serializing writers of several threads.");
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call filterSubscriptions on pipe with read access only.");
+        }
+        m_writer->filtering = true;
+        listenControl();
+    }
+
+    /*
+     * \brief Get the number of messages skipped because the reader did not subscribe to them
+     */
+    uint64_t skipped() const {
+        return m_writer ? m_writer->skipped.load(std::memory_order_relaxed) : 0;
+    }
+
+    /*
+     * \brief Advertise the identifiers with callbacks to writers filtering subscriptions when started, has to be called before start()
+     * \param maxExact Maximum number of identifiers sent exactly, more are sent as Bloom filter
+     */
+    void advertiseSubscriptions(size_t maxExact = EXACT_SUBSCRIPTIONS) {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to call advertiseSubscriptions on pipe with write access only.");
+        }
+        if (m_reader || m_detach) {
+            throw std::logic_error("Tried to advertise subscriptions on a running pipe.");
+        }
+        features().advertise = true;
+        features().advertiseExact = maxExact;
+    }
+
+    /*
+     * \brief Request the retained messages of the writer when started, has to be called before start()
+     *
+     * Messages written before the snapshot are dropped as the snapshot already reflects them,
+     * the retained messages are then delivered before the live messages.
+     * \param timeoutMs Time to wait for the snapshot before live messages are accepted
+     */
+    void requestSnapshot(int timeoutMs = SNAPSHOT_TIMEOUT_MS) {
+        // Check if read access
+        if (m_access != PipeAccess::Read) {
+            throw std::logic_error("Tried to call requestSnapshot on pipe with write access only.");
+        }
+        if (m_reader || m_detach) {
+            throw std::logic_error("Tried to request a snapshot on a running pipe.");
+        }
+        features().snapshot = SnapshotState::Waiting;
+        features().snapshotTimeoutMs = timeoutMs;
     }
 
     /*
      * \brief Write the message associated with given identifier
-     * \param id Message identifier associated with the message
+     * \param id Message identifier associated with the message, must not start with RESERVED_PREFIX
      * \param msg Message to transmit
      */
     void write(std::string id, std::string msg) {
-        int totalWritten = 0;
+        rejectReserved(id);
+        writeMessage(std::move(id), std::move(msg));
+    }
+
+    /*
+     * \brief Raise a payload-free signal, counted in shared memory until the reader drains it
+     *
+     * Signals raised before the reader woke up are delivered as one call of the signal callback
+     * with their number, only the signal making the first one pending writes a frame to wake
+     * the reader. Signals are not ordered with respect to messages.
+     * \param id Signal identifier, at most SignalTable::MAX_ID_LENGTH characters
+     */
+    void signal(std::string_view id) {
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call signal on pipe with read access only.");
+        }
+        SignalTable* table;
+        size_t slot;
+        {
+            std::lock_guard<WriteMutex> lock(m_writer->signalMutex);
+            table = &signalTable();
+            auto known = m_writer->signalSlots.find(id);
+            if (known == m_writer->signalSlots.end()) {
+                known = m_writer->signalSlots.emplace(std::string(id), table->slot(id)).first;
+            }
+            slot = known->second;
+        }
+        if (!table->raise(slot)) {
+            return;
+        }
+        // Wake the reader
+        if (m_local && m_local->hasReader()) {
+            m_local->push(SIGNAL, "");
+            return;
+        }
+        std::string frame = Framing::frame(SIGNAL, "");
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        writePending();
+        writeAll(frame.data(), frame.length());
+    }
+
+    /*
+     * \brief Write the message at the given time, written by a scheduler thread shared by all scheduled messages of the pipe
+     * \param time Time at which the message is written, past times write it with the next tick
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     */
+    void writeAt(std::chrono::steady_clock::time_point time, std::string id, std::string msg) {
+        // Scheduled messages are written by the scheduler thread
+        static_assert(Locking::CONCURRENT, "Scheduling messages needs a Locking policy serializing writers of several threads.");
         // Check if write access
         if (m_access != PipeAccess::Write) {
             throw std::logic_error("Tried to call write on pipe with read access only.");
         }
-        // Escape all PREFIX in id and msg
-        std::string& escapedId = escape(escape(escape(id, PREFIX), START), END);
-        std::string& escapedMsg = escape(escape(escape(msg, PREFIX), START), END);
-        // Create full message
-        std::string fullMsg = std::string(PREFIX) + ":" + std::string(START) + ":" + std::to_string(escapedId.size()) + ":" + std::to_string(escapedMsg.size()) + ":" + escapedId + ":" + escapedMsg + ":" + std::string(END) + ":";
-        // Loop until everything is written, we have to loop since ::write doesn't guarantee to write everything
-        while (totalWritten < msg.length()) {
-            int written = ::write(m_fd, &fullMsg.c_str()[totalWritten], fullMsg.length() - totalWritten);
-            if (written == -1) {
-                perror("write");
-                throw std::logic_error("Write to named pipe failed!");
+        rejectReserved(id);
+        {
+            std::lock_guard<std::mutex> lock(m_writer->scheduleMutex);
+            // The wheel and the scheduler thread are only created for pipes scheduling messages
+            uint64_t now = scheduleTick(std::chrono::steady_clock::now());
+            if (!m_writer->schedule) {
+                m_writer->schedule.reset(new TimerWheel<Scheduled>(now));
+                m_writer->scheduler.reset(new std::thread(std::bind(&BasicUnixPipe::handleSchedule, this)));
             }
-            totalWritten += written;
+            // Round up, a message is never written early
+            m_writer->schedule->schedule(scheduleTick(time) + 1, Scheduled{ std::move(id), std::move(msg) }, now);
+        }
+        m_writer->scheduleChanged.notify_one();
+    }
+
+    /*
+     * \brief Write the message after the given delay, see writeAt()
+     * \param delay Delay after which the message is written
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     */
+    template<typename Rep, typename Period>
+    void writeAfter(std::chrono::duration<Rep, Period> delay, std::string id, std::string msg) {
+        writeAt(std::chrono::steady_clock::now() + delay, std::move(id), std::move(msg));
+    }
+
+    /*
+     * \brief Get the number of scheduled messages not yet written
+     */
+    size_t scheduled() {
+        if (!m_writer) {
+            return 0;
+        }
+        std::lock_guard<std::mutex> lock(m_writer->scheduleMutex);
+        return m_writer->schedule ? m_writer->schedule->size() : 0;
+    }
+
+    /*
+     * \brief Write a message whose content is encoded directly into the outgoing buffer
+     * \param id Message identifier associated with the message
+     * \param length Exact number of bytes the encoder writes
+     * \param encode Callable taking a char* to length bytes of the outgoing buffer
+     */
+    template<typename Encoder>
+    void writeWith(std::string id, size_t length, Encoder&& encode) {
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call write on pipe with read access only.");
+        }
+        rejectReserved(id);
+        // Unsubscribed messages are not even encoded
+        if (unsubscribed(id)) {
+            return;
+        }
+        // Pass the message in memory if the reader lives in this process
+        if (m_local && m_local->hasReader() && waitLocal()) {
+            LocalChannel::Message* local = m_local->create(id, length);
+            encode(local->data() + id.size());
+            writeLocal(local);
+            return;
+        }
+        std::string escapedId = Framing::escape(id);
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        std::string& output = m_writer->output;
+        // Encode in place behind the frame header
+        reserveOutput(escapedId.size() + length + Framing::FRAME_OVERHEAD);
+        size_t start = output.length();
+        Framing::appendHeader(output, escapedId, length);
+        size_t contentStart = output.length();
+        output.resize(contentStart + length);
+        encode(&output[contentStart]);
+        // Rare case: the encoded content contains a tag and has to be escaped like in write()
+        std::string_view content(&output[contentStart], length);
+        if (Framing::containsTag(content)) {
+            std::string escaped = Framing::escape(content);
+            output.resize(start);
+            reserveOutput(escapedId.size() + escaped.length() + Framing::FRAME_OVERHEAD);
+            Framing::appendHeader(output, escapedId, escaped.length());
+            output += escaped;
+        }
+        Framing::appendTrailer(output);
+        m_instrumentation.record(id, output.length() - start);
+        retainFrame(id, std::string_view(output).substr(start));
+        if (output.length() >= m_config.coalesceThreshold) {
+            writePending();
+        }
+    }
+
+    /*
+     * \brief Try to write the message associated with given identifier without waiting for the reader
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     * \return False if the pipe is full and nothing was written, a partially written message is always completed
+     */
+    bool tryWrite(std::string id, std::string msg) {
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call write on pipe with read access only.");
+        }
+        rejectReserved(id);
+        if (unsubscribed(id)) {
+            return true;
+        }
+        // The in-process queue is bounded like the pipe
+        if (m_local && m_local->hasReader()) {
+            if (m_local->full(localCapacity())) {
+                return false;
+            }
+            writeLocal(std::move(id), std::move(msg));
+            return true;
+        }
+        // Create full message
+        std::string fullMsg = Framing::frame(id, msg);
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        // Pending frames have to be written first to keep the order
+        writePending();
+        ssize_t written = m_transport->write(fullMsg.data(), fullMsg.length());
+        if (written == -1 && errno == EAGAIN) {
+            return false;
+        } else if (written == -1) {
+            perror("write");
+            throw std::logic_error("Write to named pipe failed!");
+        }
+        writeAll(&fullMsg.data()[written], fullMsg.length() - written);
+        m_instrumentation.record(id, fullMsg.length());
+        retainFrame(id, fullMsg);
+        return true;
+    }
+
+    /*
+     * \brief Write all frames held back for coalescing
+     */
+    void flush() {
+        if (!m_writer) {
+            return;
         }
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        writePending();
+    }
+
+    /*
+     * \brief Get the tuning parameters of the pipe
+     */
+    PipeConfig const& config() const {
+        return m_config;
+    }
+
+    /*
+     * \brief Enable per identifier traffic counters, has to be called before start() or the first write
+     * \param exactCapacity Number of identifiers counted exactly
+     * \param topK Number of heavy hitters tracked beyond the exact identifiers
+     */
+    IdStatistics& enableStatistics(size_t exactCapacity = 64, size_t topK = 16) {
+        if (m_reader || m_detach) {
+            throw std::logic_error("Tried to enable statistics on a running pipe.");
+        }
+        return m_instrumentation.enable(exactCapacity, topK);
+    }
+
+    /*
+     * \brief Get per identifier traffic counters, nullptr if not enabled
+     */
+    IdStatistics const* statistics() const {
+        return m_instrumentation.statistics();
+    }
+
+    /*
+     * \brief Get the current size of the receive buffer in bytes
+     */
+    size_t bufferSize() const {
+        return m_bufferSize.load(std::memory_order_relaxed);
     }
 
 private:
+    friend class PipeReactor;
+
+    // Mutex of the writers, see the Locking policy
+    using WriteMutex = typename Locking::Mutex;
+
     // Name (path) of the named pipe
     std::string m_name;
     // Access type
     PipeAccess m_access;
-    // File descriptor of the opened named pipe
-    int m_fd;
+    // Tuning parameters
+    PipeConfig m_config;
+    // Byte stream carrying the frames, the named pipe unless configured otherwise
+    std::unique_ptr<PipeTransport> m_transport;
     // Atomic boolean to notify reader thread of exit
     std::atomic<bool> m_hasToStop;
+    // Current size of the receive buffer
+    std::atomic<size_t> m_bufferSize;
+    // Memory of the reader accounted with the MemoryGovernor, nullptr with write access
+    std::shared_ptr<MemoryGovernor::Account> m_account;
     // Reader thread handle
     std::unique_ptr<std::thread> m_reader;
     // Map of message identifiers associated with its callback
-    std::map<std::string, std::function<void(std::string const&)>> m_callbacks;
+    std::map<std::string, Callback, std::less<>> m_callbacks;
+    // Map of message identifiers associated with its in-place callback
+    std::map<std::string, ViewCallback, std::less<>> m_viewCallbacks;
 
     /*
-     * \brief Pipe message consisting of identifier, content and total length
+     * \brief Callback running on an executor
      */
-    struct PipeMessage {
-        // Identifier of the message
+    struct ExecutorCallback {
+        // Callback called by the executor
+        ViewCallback callback;
+        // Inbox of the pipe on the executor
+        Executor::Inbox* inbox;
+    };
+
+    // Signal counters shared with the other side, created with the first signal or signal callback
+    std::unique_ptr<SignalTable> m_signals;
+    // Optional per identifier traffic counters
+    Instrumentation m_instrumentation;
+
+    /*
+     * \brief Snapshot progress of a reader
+     */
+    enum class SnapshotState {
+        // No snapshot requested or snapshot complete, all messages are delivered
+        None,
+        // Snapshot requested, messages before its start are dropped
+        Waiting,
+        // Retained messages of the snapshot are delivered
+        Receiving,
+    };
+
+    /*
+     * \brief Retained frame with its position in the order of all writes
+     */
+    struct RetainedFrame {
+        uint64_t order;
+        std::string frame;
+    };
+
+    /*
+     * \brief Retained frames of an identifier
+     */
+    struct Retention {
+        size_t depth;
+        std::deque<RetainedFrame> frames;
+    };
+
+    /*
+     * \brief Message scheduled by writeAt
+     */
+    struct Scheduled {
         std::string id;
-        // Message content
-        std::string content;
-        // Number of characters read from input buffer
-        size_t totalLength;
+        std::string msg;
     };
 
     /*
-     * \brief Get next available message
-     * \param input Input buffer containing characters from named pipe
-     * \param filled Number of characters filled in input buffer
-     */
-    PipeMessage nextMessage(std::string const& input, size_t filled) {
-        static const std::string prefix = std::string(PREFIX) + ":" + std::string(START) + ":";
-        size_t posPrefix = 0;
-        // Create empty msg
-        PipeMessage msg;
-        msg.totalLength = 0;
-        // Remove empty if not enough data
-        if (filled < prefix.length()) {
-            return msg;
-        }
-        // Check if prefix that marks start of message
-        while (true) {
-            posPrefix = input.find_first_of(prefix, posPrefix);
-            if (posPrefix == std::string::npos) {
-                return msg;
-            } else if (posPrefix == 0 || (input[posPrefix-1] != '\\')) {
+     * \brief State of a pipe with write access, kept out of readers so idle readers stay small
+     */
+    struct WriterState {
+        WriterState() : retainedOrder(0), controlLock(-1), filtering(false), skipped(0) {}
+
+        // Frames held back for coalescing
+        std::string output;
+        // Mutex serializing writers
+        WriteMutex writeMutex;
+        // Guards the creation of the signal table and the slots
+        WriteMutex signalMutex;
+        // Slots of the raised signal identifiers
+        std::map<std::string, size_t, std::less<>> signalSlots;
+        // Retained frames per identifier, guarded by writeMutex
+        std::map<std::string, Retention, std::less<>> retained;
+        // Order of the last retained frame
+        uint64_t retainedOrder;
+        // Control pipe reading snapshot requests and subscriptions of readers
+        std::unique_ptr<BasicUnixPipe> control;
+        // Lock file holding the slot of the listening writer, -1 if none, see listeners()
+        int controlLock;
+        // Skip identifiers not advertised by the reader
+        bool filtering;
+        // Identifiers advertised by the reader, nullptr if all are sent
+        std::shared_ptr<SubscriptionFilter const> subscriptions;
+        // Number of skipped messages
+        std::atomic<uint64_t> skipped;
+        // Scheduled messages by due tick, created with the first scheduled message
+        std::unique_ptr<TimerWheel<Scheduled>> schedule;
+        // Guards the scheduled messages
+        std::mutex scheduleMutex;
+        // Signals the scheduler thread about new messages and stop requests
+        std::condition_variable scheduleChanged;
+        // Scheduler thread handle
+        std::unique_ptr<std::thread> scheduler;
+    };
+
+    /*
+     * \brief Optional features of a reader, set up before it is started
+     */
+    struct ReaderFeatures {
+        ReaderFeatures() : snapshot(SnapshotState::None), snapshotTimeoutMs(0), snapshotPending(0), advertise(false), advertiseExact(0) {}
+
+        // Map of message identifiers associated with callbacks running on executors
+        std::map<std::string, ExecutorCallback, std::less<>> executorCallbacks;
+        // Inboxes of the pipe on all executors it routes messages to
+        std::map<Executor*, std::shared_ptr<Executor::Inbox>> inboxes;
+        // Slots of the signal identifiers associated with their callback
+        std::map<size_t, SignalCallback> signalCallbacks;
+        // Snapshot progress, only used by the reader thread once started
+        SnapshotState snapshot;
+        // Time to wait for a requested snapshot
+        int snapshotTimeoutMs;
+        // Number of listening writers whose SNAPSHOT_END is still expected
+        size_t snapshotPending;
+        // Time after which live messages are accepted without snapshot
+        std::chrono::steady_clock::time_point snapshotDeadline;
+        // Control pipes of the listening writers the requests were sent to
+        std::vector<std::unique_ptr<BasicUnixPipe>> controls;
+        // Advertise the identifiers with callbacks when started
+        bool advertise;
+        // Maximum number of identifiers advertised exactly
+        size_t advertiseExact;
+    };
+
+    // State of writing, nullptr with read access
+    std::unique_ptr<WriterState> m_writer;
+    // Executors, signal callbacks and requests to writers of a reader, nullptr until the first one is set up
+    std::unique_ptr<ReaderFeatures> m_features;
+    // In-process channel used while writer and reader live in the same process
+    std::shared_ptr<LocalChannel> m_local;
+    // Receive buffer, empty while a pipe served by a reactor hibernates
+    std::string m_input;
+    // Number of received bytes in the receive buffer not yet processed
+    size_t m_filled;
+    // Reused storage of unescaped contents and identifiers handed to callbacks
+    std::string m_decoded;
+    std::string m_decodedId;
+    // Sizes the receive buffer, records the received frame sizes
+    Buffer m_buffer;
+    // Size of a new receive buffer
+    size_t m_baseSize;
+    // Growth of the receive buffer if a frame does not fit
+    size_t m_growStep;
+    // Time of the last message received by a pipe served by a reactor
+    std::chrono::steady_clock::time_point m_lastActivity;
+    // Bytes and messages left in the current turn of a pipe served by a reactor, unlimited with an own reader thread
+    size_t m_deficitBytes;
+    size_t m_deficitMessages;
+    // Pipe is in the ready list of the reactor serving it
+    bool m_ready;
+    // Removes the pipe from the reactor serving it, empty if served by its own thread, only captures the reactor and the pipe
+    using Detach = InlineFunction<void(), 2 * sizeof(void*)>;
+    Detach m_detach;
+
+    /*
+     * \brief Get the optional features of the reader, created on first use before it is started
+     */
+    ReaderFeatures& features() {
+        if (!m_features) {
+            m_features.reset(new ReaderFeatures());
+        }
+        return *m_features;
+    }
+
+    /*
+     * \brief Convert a point in time to a tick of the schedule
+     */
+    static uint64_t scheduleTick(std::chrono::steady_clock::time_point time) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count() / SCHEDULE_TICK_US);
+    }
+
+    /*
+     * \brief Scheduler thread routine that writes scheduled messages when they are due
+     */
+    void handleSchedule() {
+        std::vector<Scheduled> due;
+        WriterState& writer = *m_writer;
+        std::unique_lock<std::mutex> lock(writer.scheduleMutex);
+        while (!m_hasToStop) {
+            writer.schedule->advance(scheduleTick(std::chrono::steady_clock::now()), [&due](Scheduled&& scheduled) {
+                due.push_back(std::move(scheduled));
+            });
+            // Write without holding the lock so scheduling does not wait for a full pipe
+            if (!due.empty()) {
+                lock.unlock();
+                for (Scheduled& scheduled : due) {
+                    // A failed write only loses this message, later ones are still written
+                    try {
+                        writeMessage(std::move(scheduled.id), std::move(scheduled.msg));
+                    } catch (std::logic_error& ex) {
+                        std::cerr << ex.what() << std::endl;
+                    }
+                }
+                due.clear();
+                lock.lock();
+                continue;
+            }
+            uint64_t next = writer.schedule->nextExpiry();
+            if (next == TimerWheel<Scheduled>::NEVER) {
+                writer.scheduleChanged.wait(lock);
+            } else {
+                writer.scheduleChanged.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::microseconds(next * SCHEDULE_TICK_US)));
+            }
+        }
+    }
+
+    /*
+     * \brief Get the configuration of the control pipe, a named pipe if the pipe uses sockets since requests have to wait for a writer
+     */
+    PipeConfig controlConfig() const {
+        PipeConfig config = m_config;
+        if (config.transport == TransportType::SeqPacket) {
+            config.transport = TransportType::Fifo;
+        }
+        return config;
+    }
+
+    /*
+     * \brief Send the subscriptions and the snapshot request of a starting reader to every listening writer
+     */
+    void announce() {
+        if (!m_features || (!m_features->advertise && m_features->snapshot != SnapshotState::Waiting)) {
+            return;
+        }
+        ReaderFeatures& features = *m_features;
+        std::vector<size_t> slots = listeners();
+        // Without a listening writer nobody answers the request, live messages are delivered right away
+        if (slots.empty()) {
+            features.snapshot = SnapshotState::None;
+        }
+        // Subscriptions wait in the control pipe of the first writer to listen, like a single writer finds them once it starts
+        if (slots.empty() && features.advertise) {
+            slots.push_back(0);
+        }
+        std::string subscriptions;
+        if (features.advertise) {
+            std::set<std::string> ids;
+            for (auto const& callback : m_callbacks) {
+                ids.insert(callback.first);
+            }
+            for (auto const& callback : m_viewCallbacks) {
+                ids.insert(callback.first);
+            }
+            for (auto const& callback : features.executorCallbacks) {
+                ids.insert(callback.first);
+            }
+            subscriptions = SubscriptionFilter::encode(ids, features.advertiseExact);
+        }
+        for (size_t slot : slots) {
+            features.controls.emplace_back(new BasicUnixPipe(controlName(slot), PipeAccess::Write, controlConfig()));
+            if (features.advertise) {
+                features.controls.back()->writeMessage(SUBSCRIBE, subscriptions);
+            }
+            if (features.snapshot == SnapshotState::Waiting) {
+                features.controls.back()->writeMessage(SNAPSHOT_REQUEST, "");
+            }
+            features.controls.back()->flush();
+        }
+        // Each writer answers with its own snapshot, the reader waits for all of them
+        if (features.snapshot == SnapshotState::Waiting) {
+            features.snapshotPending = slots.size();
+            features.snapshotDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(features.snapshotTimeoutMs);
+        }
+    }
+
+    /*
+     * \brief Start reading snapshot requests and subscriptions of readers on the writer
+     *
+     * Every listening writer holds a write lock on its own byte (slot) of the lock file NAME.ctl
+     * and reads the control pipe of that slot, so each one receives the requests of a reader.
+     */
+    void listenControl() {
+        WriterState& writer = *m_writer;
+        if (writer.control) {
+            return;
+        }
+        size_t slot = 0;
+        if (controlConfig().transport == TransportType::Fifo) {
+            writer.controlLock = open((m_name + CONTROL_SUFFIX).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+            if (writer.controlLock == -1) {
+                perror("open");
+                throw std::logic_error("Opening the control lock file failed!");
+            }
+            // The lowest free slot, held until the lock file is closed
+            while (slot < MAX_LISTENERS && !lockSlot(slot)) {
+                ++slot;
+            }
+            if (slot == MAX_LISTENERS) {
+                close(writer.controlLock);
+                writer.controlLock = -1;
+                throw std::logic_error("Tried to listen on a pipe with too many listening writers.");
+            }
+        }
+        writer.control.reset(new BasicUnixPipe(controlName(slot), PipeAccess::Read, controlConfig()));
+        writer.control->addCallback(SNAPSHOT_REQUEST, [this](std::string const&) {
+            replaySnapshot();
+        });
+        writer.control->addCallback(SUBSCRIBE, [this](std::string const& msg) {
+            std::shared_ptr<SubscriptionFilter const> filter;
+            if (!msg.empty()) {
+                filter = std::make_shared<SubscriptionFilter const>(msg);
+            }
+            std::atomic_store(&m_writer->subscriptions, filter);
+        });
+        // An advertising reader that crashed cannot withdraw its subscriptions, its control pipe end closes anyway
+        writer.control->detectHangup();
+        writer.control->addCallback(HANGUP, [this](std::string const&) {
+            std::atomic_store(&m_writer->subscriptions, std::shared_ptr<SubscriptionFilter const>());
+        });
+        writer.control->start();
+    }
+
+    /*
+     * \brief Watch the named pipe of a reader for all writers leaving, they call the HANGUP callback, has to be called before start()
+     */
+    void detectHangup() {
+        if (m_config.transport == TransportType::Fifo) {
+            m_transport.reset(new FifoTransport(m_name, m_config.capacity, true));
+        }
+    }
+
+    /*
+     * \brief Get the name of the control pipe of a listening writer
+     * \param slot Slot of the writer in the lock file
+     */
+    std::string controlName(size_t slot) const {
+        return m_name + CONTROL_SUFFIX + "." + std::to_string(slot);
+    }
+
+    /*
+     * \brief Try to take a slot of the lock file, open file description locks are released when the lock file is closed
+     */
+    bool lockSlot(size_t slot) {
+        struct flock lock;
+        std::memset(&lock, 0, sizeof(lock));
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET;
+        lock.l_start = static_cast<off_t>(slot);
+        lock.l_len = 1;
+        return fcntl(m_writer->controlLock, F_OFD_SETLK, &lock) == 0;
+    }
+
+    /*
+     * \brief Get the slots of the writers listening for requests, each one holds the lock of its slot
+     */
+    std::vector<size_t> listeners() const {
+        std::vector<size_t> slots;
+        // The in-memory transport has no file to lock, its writers share the control pipe of slot 0 and its readers wait for one snapshot
+        if (controlConfig().transport != TransportType::Fifo) {
+            slots.push_back(0);
+            return slots;
+        }
+        int fd = open((m_name + CONTROL_SUFFIX).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return slots;
+        }
+        // Each query reports the first held slot of the remaining range
+        size_t slot = 0;
+        while (slot < MAX_LISTENERS) {
+            struct flock lock;
+            std::memset(&lock, 0, sizeof(lock));
+            lock.l_type = F_WRLCK;
+            lock.l_whence = SEEK_SET;
+            lock.l_start = static_cast<off_t>(slot);
+            lock.l_len = static_cast<off_t>(MAX_LISTENERS - slot);
+            if (fcntl(fd, F_OFD_GETLK, &lock) == -1 || lock.l_type == F_UNLCK) {
                 break;
             }
+            slots.push_back(static_cast<size_t>(lock.l_start));
+            slot = static_cast<size_t>(lock.l_start) + 1;
+        }
+        close(fd);
+        return slots;
+    }
+
+    /*
+     * \brief Check if a message is skipped since the reader did not subscribe to its identifier
+     * \param id Message identifier
+     */
+    bool unsubscribed(std::string const& id) {
+        WriterState& writer = *m_writer;
+        if (!writer.filtering) {
+            return false;
+        }
+        std::shared_ptr<SubscriptionFilter const> filter = std::atomic_load(&writer.subscriptions);
+        if (!filter || filter->matches(id)) {
+            return false;
+        }
+        // Retained messages are still needed for the snapshots of later readers
+        std::lock_guard<WriteMutex> lock(writer.writeMutex);
+        if (writer.retained.find(id) != writer.retained.end()) {
+            return false;
+        }
+        writer.skipped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*
+     * \brief Write a message of any identifier, see write()
+     */
+    void writeMessage(std::string id, std::string msg) {
+        // Check if write access
+        if (m_access != PipeAccess::Write) {
+            throw std::logic_error("Tried to call write on pipe with read access only.");
         }
-        // Check if first separator exists
-        size_t posEndIdLen = input.find_first_of(':', posPrefix + prefix.length());
-        if (posEndIdLen == std::string::npos) {
-            return msg;
+        if (unsubscribed(id)) {
+            return;
         }
-        // Check if second separator exists
-        size_t posEndMsgLen = input.find_first_of(':', posEndIdLen + 1);
-        if (posEndMsgLen == std::string::npos) {
-            return msg;
+        // Pass the message in memory if the reader lives in this process
+        if (m_local && m_local->hasReader() && waitLocal()) {
+            writeLocal(std::move(id), std::move(msg));
+            return;
         }
-        // Retrieve id and message length
-        size_t idLen;
-        size_t msgLen;
-        std::string idLenStr = input.substr(prefix.length(), posEndIdLen - (prefix.length()));
-        std::string msgLenStr = input.substr(posEndIdLen + 1, posEndMsgLen - (posEndIdLen + 1));
-        // Check if strings can be transformed into numbers
-        try {
-            idLen = std::stoul(idLenStr);
-            msgLen = std::stoul(msgLenStr);
-        } catch(std::invalid_argument& ex) {
-            return msg;
+        // Create full message
+        std::string fullMsg = Framing::frame(id, msg);
+        m_instrumentation.record(id, fullMsg.length());
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        retainFrame(id, fullMsg);
+        // Write directly if nothing is pending and coalescing would not hold back the message
+        if (m_writer->output.empty() && fullMsg.length() >= m_config.coalesceThreshold) {
+            writeAll(fullMsg.data(), fullMsg.length());
+            return;
         }
-        // Check if total length is enough
-        size_t totalLength = posEndMsgLen + idLen + msgLen + 4 + std::strlen(END);
-        if (filled < totalLength || (input.find_first_of(END, totalLength - std::strlen(END) - 1) != (totalLength - std::strlen(END) - 1)) || input[totalLength - 1] != ':') {
-            return msg;
+        // Otherwise collect frames until the coalescing threshold is reached
+        appendOutput(fullMsg);
+        if (m_writer->output.length() >= m_config.coalesceThreshold) {
+            writePending();
         }
-        // Extract id and message
-        msg.totalLength = totalLength;
-        std::string id = input.substr(posEndMsgLen + 1, idLen);
-        msg.id = unescape(unescape(unescape(id, PREFIX), START), END);
-        std::string content = input.substr(posEndMsgLen + idLen + 2, msgLen);
-        msg.content = unescape(unescape(unescape(content, PREFIX), START), END);
-        // Return
-        return msg;
     }
 
     /*
-     * \brief Revert previously escaped tag
-     * \param str Input string
-     * \param tag Tag to unescape
+     * \brief Reject identifiers starting with RESERVED_PREFIX, internal messages must not be written or hijacked by users
      */
-    std::string& unescape(std::string& str, const char* const tag) {
-        size_t pos = 0;
-        static size_t const tagLength = std::strlen(tag);
-        static std::string const escapedTag = "\\" + std::string(tag);
-        // Unescape all tags
-        while((pos = str.find(escapedTag, pos)) != std::string::npos) {
-            str.replace(pos, tagLength + 1, tag);
-            pos += tagLength + 1;
+    static void rejectReserved(std::string_view id) {
+        if (id.substr(0, std::char_traits<char>::length(RESERVED_PREFIX)) == RESERVED_PREFIX) {
+            throw std::logic_error("Tried to write a message with a reserved identifier.");
         }
-        return str;
     }
 
     /*
-     * \brief Escape tag in string
-     * \param str Input string
-     * \param tag Tag to escape
+     * \brief Get the bytes the in-process queue may hold before writers wait, the configured pipe capacity
      */
-    std::string& escape(std::string& str, const char* const tag) {
-        size_t pos = 0;
-        static size_t const tagLength = std::strlen(tag);
-        static std::string const escapedTag = "\\" + std::string(tag);
-        // Escape all tags
-        while((pos = str.find(tag, pos)) != std::string::npos) {
-            str.replace(pos, tagLength, escapedTag.c_str());
-            pos += escapedTag.length();
+    size_t localCapacity() const {
+        return m_config.capacity > 0 ? m_config.capacity : LocalChannel::DEFAULT_CAPACITY;
+    }
+
+    /*
+     * \brief Wait while the in-process queue is full, like a writer of a full pipe
+     * \return False if the reader left meanwhile and the message goes through the transport
+     */
+    bool waitLocal() {
+        size_t capacity = localCapacity();
+        while (m_local->full(capacity) && m_local->hasReader()) {
+            m_local->waitRoom(capacity, POLL_TIMEOUT_MS);
         }
-        return str;
+        return m_local->hasReader();
+    }
+
+    /*
+     * \brief Queue a message for the reader of this process without framing
+     * \param id Message identifier associated with the message
+     * \param msg Message to transmit
+     */
+    void writeLocal(std::string_view id, std::string_view msg) {
+        LocalChannel::Message* local = m_local->create(id, msg.size());
+        std::memcpy(local->data() + id.size(), msg.data(), msg.size());
+        writeLocal(local);
+    }
+
+    /*
+     * \brief Queue a message created in the in-process channel
+     * \param msg Message with identifier and content filled in
+     */
+    void writeLocal(LocalChannel::Message* msg) {
+        m_instrumentation.record(msg->id, msg->id.size() + msg->content.size());
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        // Frames held back for coalescing precede the message
+        writePending();
+        // Snapshots are replayed through the named pipe and need the frame
+        std::map<std::string, Retention, std::less<>> const& retained = m_writer->retained;
+        if (!retained.empty() && retained.find(msg->id) != retained.end()) {
+            retainFrame(msg->id, Framing::frame(msg->id, msg->content));
+        }
+        m_local->push(msg);
+    }
+
+    /*
+     * \brief Store a written frame if its identifier is retained, WriterState::writeMutex has to be held
+     * \param id Message identifier
+     * \param frame Complete frame
+     */
+    void retainFrame(std::string_view id, std::string_view frame) {
+        WriterState& writer = *m_writer;
+        if (writer.retained.empty()) {
+            return;
+        }
+        auto retention = writer.retained.find(id);
+        if (retention != writer.retained.end()) {
+            retention->second.frames.push_back(RetainedFrame{ ++writer.retainedOrder, std::string(frame) });
+            if (retention->second.frames.size() > retention->second.depth) {
+                retention->second.frames.pop_front();
+            }
+        }
+    }
+
+    /*
+     * \brief Write all retained frames in their original order enclosed by SNAPSHOT_BEGIN and SNAPSHOT_END
+     */
+    void replaySnapshot() {
+        std::string begin = Framing::frame(SNAPSHOT_BEGIN, "");
+        std::string end = Framing::frame(SNAPSHOT_END, "");
+        std::lock_guard<WriteMutex> lock(m_writer->writeMutex);
+        std::vector<RetainedFrame const*> frames;
+        for (auto const& retention : m_writer->retained) {
+            for (RetainedFrame const& retained : retention.second.frames) {
+                frames.push_back(&retained);
+            }
+        }
+        std::sort(frames.begin(), frames.end(), [](RetainedFrame const* lhs, RetainedFrame const* rhs) {
+            return lhs->order < rhs->order;
+        });
+        // A reader in this process receives the snapshot in order with the live messages through the in-process queue
+        if (m_local && m_local->hasReader()) {
+            writePending();
+            m_local->push(SNAPSHOT_BEGIN, "");
+            for (RetainedFrame const* retained : frames) {
+                std::string id;
+                typename Framing::Message message = Framing::next(retained->frame, id);
+                m_local->push(message.id, Framing::unescape(message.content));
+            }
+            m_local->push(SNAPSHOT_END, "");
+            return;
+        }
+        // Held back frames were written before the snapshot was taken
+        appendOutput(begin);
+        for (RetainedFrame const* retained : frames) {
+            appendOutput(retained->frame);
+        }
+        appendOutput(end);
+        writePending();
+    }
+
+    /*
+     * \brief Get the signal table of the pipe, created on first use
+     *
+     * Writers signal from any thread and hold WriterState::signalMutex, readers create it before they are started.
+     */
+    SignalTable& signalTable() {
+        if (!m_signals) {
+            m_signals.reset(new SignalTable(m_name + SIGNAL_SUFFIX));
+        }
+        return *m_signals;
+    }
+
+    /*
+     * \brief Call the signal callbacks of all pending signals
+     */
+    void drainSignals() {
+        if (!m_signals) {
+            return;
+        }
+        // Readers create the signal table with their first signal callback
+        std::map<size_t, SignalCallback>& callbacks = m_features->signalCallbacks;
+        m_signals->drain([&callbacks](size_t slot, uint64_t count) {
+            auto callback = callbacks.find(slot);
+            if (callback != callbacks.end()) {
+                callback->second(count);
+            }
+        });
+    }
+
+    /*
+     * \brief Check if a received message is delivered with respect to a requested snapshot
+     * \param id Message identifier
+     */
+    bool acceptSnapshot(std::string_view id) {
+        ReaderFeatures& features = *m_features;
+        if (id == SNAPSHOT_BEGIN) {
+            // Only the first of the snapshots of several writers is delivered as begin
+            bool first = features.snapshot == SnapshotState::Waiting;
+            features.snapshot = SnapshotState::Receiving;
+            return first;
+        } else if (id == SNAPSHOT_END) {
+            // The snapshot is complete once every listening writer answered
+            if (features.snapshotPending > 1) {
+                --features.snapshotPending;
+                return false;
+            }
+            features.snapshotPending = 0;
+            features.snapshot = SnapshotState::None;
+        } else if (features.snapshot == SnapshotState::Waiting && std::chrono::steady_clock::now() < features.snapshotDeadline) {
+            // Older than the snapshot, which already reflects it
+            return false;
+        } else if (features.snapshot == SnapshotState::Waiting) {
+            // No writer retains messages, go live
+            features.snapshot = SnapshotState::None;
+        }
+        return true;
+    }
+
+    /*
+     * \brief Check if a snapshot was requested and is not yet complete
+     */
+    bool snapshotPending() const {
+        return m_features && m_features->snapshot != SnapshotState::None;
+    }
+
+    /*
+     * \brief Check if callbacks of any identifier run on executors
+     */
+    bool routesExecutors() const {
+        return m_features && !m_features->executorCallbacks.empty();
+    }
+
+    /*
+     * \brief Lock the allocated storage of a buffer into memory if configured
+     * \param buffer Buffer to lock, its storage is already faulted in
+     */
+    void lockBuffer(std::string const& buffer) {
+        if (m_config.lockMemory && buffer.capacity() > 0 && mlock(buffer.data(), buffer.capacity()) == -1) {
+            perror("mlock");
+        }
+    }
+
+    /*
+     * \brief Unlock the allocated storage of a buffer previously locked by lockBuffer
+     * \param buffer Buffer to unlock
+     */
+    void unlockBuffer(std::string const& buffer) {
+        if (m_config.lockMemory && buffer.capacity() > 0) {
+            munlock(buffer.data(), buffer.capacity());
+        }
+    }
+
+    /*
+     * \brief Fault in and lock the stack pages the reader thread runs on
+     *
+     * Pages stay locked after returning, so the callbacks called later run on resident stack.
+     */
+    __attribute__((noinline)) void lockStack() {
+        volatile char stack[LOCKED_STACK_SIZE];
+        for (size_t idx = 0; idx < LOCKED_STACK_SIZE; idx += 4096) {
+            stack[idx] = 0;
+        }
+        if (mlock(const_cast<char*>(stack), LOCKED_STACK_SIZE) == -1) {
+            perror("mlock");
+        }
+    }
+
+    /*
+     * \brief Make room for the given number of bytes behind the pending frames of the send buffer
+     *
+     * In latency mode the pre-faulted buffer grows by doubling and is locked again like the
+     * receive buffer in growBuffer(), otherwise the string grows as it likes.
+     */
+    void reserveOutput(size_t length) {
+        std::string& output = m_writer->output;
+        size_t pending = output.length();
+        if (m_config.prefaultSize == 0 || pending + length <= output.capacity()) {
+            return;
+        }
+        unlockBuffer(output);
+        // Fault in the whole new storage before it is locked
+        output.resize(std::max(output.capacity() * 2, pending + length), '\0');
+        output.resize(pending);
+        lockBuffer(output);
+    }
+
+    /*
+     * \brief Append data to the send buffer, see reserveOutput()
+     */
+    void appendOutput(std::string_view data) {
+        reserveOutput(data.size());
+        m_writer->output += data;
+    }
+
+    /*
+     * \brief Write the frames held back for coalescing, WriterState::writeMutex has to be held
+     */
+    void writePending() {
+        std::string& output = m_writer->output;
+        if (!output.empty()) {
+            writeAll(output.data(), output.length());
+            output.clear();
+        }
+    }
+
+    /*
+     * \brief Grow receive buffer, in latency mode by doubling to keep growth (and page faults) rare
+     */
+    void growBuffer() {
+        if (m_config.prefaultSize > 0) {
+            unlockBuffer(m_input);
+            m_input.resize(std::max(m_input.size() * 2, m_input.size() + m_config.readSize), '\0');
+            lockBuffer(m_input);
+        } else {
+            m_input.resize(m_input.size() + m_growStep);
+        }
+        bufferChanged();
+    }
+
+    /*
+     * \brief Adapt the receive buffer to the base size computed by the buffer policy, an empty oversized buffer is swapped for a smaller one
+     */
+    void adaptBuffer() {
+        m_buffer.adapt(m_transport->batchSize(), m_baseSize, m_growStep);
+        if (m_input.size() < m_baseSize) {
+            m_input.resize(m_baseSize);
+        } else if (m_filled == 0 && m_input.size() > SHRINK_FACTOR * m_baseSize) {
+            BufferPool::instance().release(std::move(m_input));
+            m_input = BufferPool::instance().acquire(m_baseSize);
+        }
+        bufferChanged();
+    }
+
+    /*
+     * \brief Publish the size of the receive buffer and account its allocation with the memory governor
+     */
+    void bufferChanged() {
+        m_bufferSize.store(m_input.size(), std::memory_order_relaxed);
+        m_account->setBuffer(m_input.empty() ? 0 : m_input.capacity());
+    }
+
+    /*
+     * \brief Carry out the requests of the memory governor, called by the reader
+     * \return False if the reader is paused and must not read
+     */
+    bool relieveMemory() {
+        uint32_t requests = m_account->requests();
+        if (requests == 0) {
+            return true;
+        }
+        // Hibernated pipes hold no buffer, latency mode keeps its locked one
+        bool resizable = !m_input.empty() && m_config.prefaultSize == 0;
+        if ((requests & MemoryGovernor::DROP) != 0 && resizable) {
+            // Complete frames left for the next turn are kept, the rest of the dropped frame is skipped as data without frame start
+            m_filled = completeLength();
+        }
+        // Buffers without a partial frame shrink, complete frames move along
+        if (resizable && m_input.size() > m_baseSize && m_filled <= m_baseSize && completeLength() == m_filled) {
+            std::string smaller = BufferPool::instance().acquire(m_baseSize);
+            std::memcpy(&smaller[0], m_input.data(), m_filled);
+            // Freed instead of pooled, the governor just emptied the pool
+            std::string().swap(m_input);
+            m_input = std::move(smaller);
+            bufferChanged();
+        }
+        m_account->handled(requests);
+        return (requests & MemoryGovernor::PAUSE) == 0;
+    }
+
+    /*
+     * \brief Get the number of bytes of the complete frames at the start of the receive buffer
+     */
+    size_t completeLength() {
+        size_t complete = 0;
+        while (complete < m_filled) {
+            typename Framing::Message msg = Framing::next(std::string_view(&m_input[complete], m_filled - complete), m_decodedId);
+            if (msg.totalLength == 0) {
+                break;
+            }
+            complete += msg.totalLength;
+        }
+        return complete;
+    }
+
+    /*
+     * \brief Write the given bytes completely, waiting for the reader if the pipe is full
+     * \param data Bytes to write
+     * \param length Number of bytes to write
+     * \param timeoutMs Maximum time to wait for room, -1 waits as long as it takes
+     * \return False if the time ran out before everything was written
+     */
+    bool writeAll(char const* data, size_t length, int timeoutMs = -1) {
+        // Only taken once the pipe is full, the common path reads no clock
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        size_t totalWritten = 0;
+        // Loop until everything is written, we have to loop since ::write doesn't guarantee to write everything
+        while (totalWritten < length) {
+            ssize_t written = m_transport->write(&data[totalWritten], length - totalWritten);
+            if (written == -1 && errno == EAGAIN) {
+                if (timeoutMs >= 0) {
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    if (deadline == std::chrono::steady_clock::time_point::max()) {
+                        deadline = now + std::chrono::milliseconds(timeoutMs);
+                    } else if (now >= deadline) {
+                        return false;
+                    }
+                }
+                // Pipe is full, wait until the reader made some room instead of tearing the message apart
+                m_transport->waitWritable(POLL_TIMEOUT_MS);
+                continue;
+            } else if (written == -1) {
+                perror("write");
+                throw std::logic_error("Write to named pipe failed!");
+            }
+            totalWritten += written;
+        }
+        return true;
+    }
+
+    /*
+     * \brief Check if a callback of any kind is registered for an identifier
+     */
+    bool hasCallback(std::string_view id) const {
+        return m_callbacks.find(id) != m_callbacks.end() || m_viewCallbacks.find(id) != m_viewCallbacks.end()
+            || (m_features && m_features->executorCallbacks.find(id) != m_features->executorCallbacks.end());
+    }
+
+    /*
+     * \brief Queue a message for the executor running the callback of its identifier
+     * \param id Message identifier
+     * \param content Message content
+     * \param escaped True if the content may still be escaped
+     * \return False if the callback of the identifier does not run on an executor
+     */
+    bool queueExecutor(std::string_view id, std::string_view content, bool escaped) {
+        auto routed = m_features->executorCallbacks.find(id);
+        if (routed == m_features->executorCallbacks.end()) {
+            return false;
+        }
+        if (escaped && Framing::escaped(content)) {
+            Framing::unescapeTo(content, m_decoded);
+            content = m_decoded;
+        }
+        routed->second.inbox->push([](void const* handler, std::string_view msg) {
+            (*static_cast<ViewCallback const*>(handler))(msg);
+        }, &routed->second.callback, content);
+        return true;
+    }
+
+    /*
+     * \brief Call the callbacks of all messages queued by writers of this process
+     * \return True if any message was queued
+     */
+    bool readLocal() {
+        bool any = false;
+        while (!exhausted()) {
+            LocalChannel::Message* msg = m_local->pop();
+            if (msg == nullptr) {
+                break;
+            }
+            any = true;
+            spend(msg->id.size() + msg->content.size(), 1);
+            m_instrumentation.record(msg->id, msg->id.size() + msg->content.size());
+            if (msg->id == SIGNAL) {
+                drainSignals();
+                continue;
+            }
+            // Drop messages preceding a requested snapshot
+            if (snapshotPending() && !acceptSnapshot(msg->id)) {
+                continue;
+            }
+            if (routesExecutors() && queueExecutor(msg->id, msg->content, false)) {
+                continue;
+            }
+            auto viewCallback = m_viewCallbacks.find(msg->id);
+            if (viewCallback != m_viewCallbacks.end()) {
+                viewCallback->second(msg->content);
+                continue;
+            }
+            auto callback = m_callbacks.find(msg->id);
+            if (callback != m_callbacks.end()) {
+                m_decoded.assign(msg->content);
+                callback->second(m_decoded);
+            }
+        }
+        // Queued messages live in the slab of the channel
+        m_account->setQueue(m_local->slab().reserved());
+        return any;
+    }
+
+    /*
+     * \brief Read available data from the transport and call the callbacks of all complete messages
+     * \param limit Maximum number of bytes to read, packet transports read at least a batch
+     * \return Number of bytes read, 0 or -1 if none were available
+     */
+    int readTransport(size_t limit = SIZE_MAX) {
+        // A hibernated pipe takes a buffer out of the pool again
+        if (m_input.empty()) {
+            m_input = BufferPool::instance().acquire(m_baseSize);
+            bufferChanged();
+        }
+        size_t length = std::min(m_input.size() - m_filled, std::max(limit, m_transport->batchSize()));
+        int read = static_cast<int>(m_transport->read(&m_input[m_filled], length));
+        // Check if some error other than missing writer exists
+        if (read == -1 && errno != ENXIO && errno != EAGAIN) {
+            throw std::logic_error("Reading from named pipe failed!");
+        } else if (read > 0) {
+            m_filled += read;
+            spend(read, 0);
+            processFrames();
+        } else if (m_transport->hungUp()) {
+            auto callback = m_callbacks.find(HANGUP);
+            if (callback != m_callbacks.end()) {
+                m_decoded.clear();
+                callback->second(m_decoded);
+            }
+        }
+        return read;
+    }
+
+    /*
+     * \brief Call the callbacks of the complete messages in the receive buffer, messages beyond the deficit stay in it
+     */
+    void processFrames() {
+        size_t consumed = 0;
+        while (m_deficitMessages > 0) {
+            // Check if message if fully read
+            typename Framing::Message msg = Framing::next(std::string_view(&m_input[consumed], m_filled - consumed), m_decodedId);
+            if (msg.totalLength == 0) {
+                break;
+            }
+            consumed += msg.totalLength;
+            // Skip data that does not form a message
+            if (!msg.valid) {
+                continue;
+            }
+            --m_deficitMessages;
+            m_instrumentation.record(msg.id, msg.totalLength);
+            if (m_config.prefaultSize == 0) {
+                m_buffer.record(msg.totalLength);
+            }
+            // Signals are counted in the signal table, the message only wakes the reader
+            if (msg.id == SIGNAL) {
+                drainSignals();
+                continue;
+            }
+            // Drop messages preceding a requested snapshot
+            bool accepted = !snapshotPending() || acceptSnapshot(msg.id);
+            if (accepted && routesExecutors() && queueExecutor(msg.id, msg.content, true)) {
+                continue;
+            }
+            // If callback is registered for the identifier, call it
+            auto viewCallback = m_viewCallbacks.find(msg.id);
+            auto callback = m_callbacks.find(msg.id);
+            if (accepted && viewCallback != m_viewCallbacks.end()) {
+                // Content is only copied if it has to be unescaped
+                if (!Framing::escaped(msg.content)) {
+                    viewCallback->second(msg.content);
+                } else {
+                    Framing::unescapeTo(msg.content, m_decoded);
+                    viewCallback->second(m_decoded);
+                }
+            } else if (accepted && callback != m_callbacks.end()) {
+                Framing::unescapeTo(msg.content, m_decoded);
+                callback->second(m_decoded);
+            }
+        }
+        // Remove processed part once, only the filled part has to be moved
+        if (consumed > 0) {
+            m_filled -= consumed;
+            std::memmove(&m_input[0], &m_input[consumed], m_filled);
+        }
+        // A buffer of messages left for the next turn neither grows nor shrinks
+        if (m_deficitMessages == 0) {
+            return;
+        }
+        if (m_buffer.due()) {
+            adaptBuffer();
+        }
+        if (m_filled == m_input.size()) {
+            // Increase buffer if no full message is retrieved and input is full
+            growBuffer();
+        }
+    }
+
+    /*
+     * \brief Check if the deficit of the current turn is used up
+     */
+    bool exhausted() const {
+        return m_deficitBytes == 0 || m_deficitMessages == 0;
+    }
+
+    /*
+     * \brief Charge received bytes and messages to the deficit of the current turn
+     */
+    void spend(size_t bytes, size_t messages) {
+        m_deficitBytes -= std::min(m_deficitBytes, bytes);
+        m_deficitMessages -= std::min(m_deficitMessages, messages);
+    }
+
+    /*
+     * \brief Process the data available on a pipe served by a reactor within the deficit of its turn, called by the reactor thread
+     * \return True if the deficit ran out, so data may be left for the next turn
+     */
+    bool readAvailable() {
+        bool any = false;
+        // Also picks up signals left pending by a previous reader whose wakeup was already consumed
+        drainSignals();
+        // Messages left over by the previous turn come first
+        if (m_filled > 0) {
+            processFrames();
+        }
+        // A hibernated pipe only takes a buffer out of the pool if the transport has data
+        m_transport->wakeUp();
+        if (!exhausted() && (!m_input.empty() || m_transport->readable())) {
+            while (!exhausted() && readTransport(m_deficitBytes) > 0) {
+                any = true;
+            }
+        }
+        // Drain the in-process queue until the reactor can wait for its eventfd again
+        if (m_local) {
+            m_local->wakeUp();
+            do {
+                any = readLocal() || any;
+            } while (!exhausted() && !m_local->prepareSleep());
+        }
+        if (any) {
+            m_lastActivity = std::chrono::steady_clock::now();
+        }
+        return exhausted();
+    }
+
+    /*
+     * \brief Hand the receive buffer of an idle pipe served by a reactor back to the pool
+     * \return True if the buffer was released
+     */
+    bool hibernate() {
+        // Partial frames and the pre-faulted buffers of latency mode stay
+        if (m_filled > 0 || m_input.empty() || m_config.prefaultSize > 0) {
+            return false;
+        }
+        BufferPool::instance().release(std::move(m_input));
+        m_input = std::string();
+        BufferPool::instance().release(std::move(m_decoded));
+        m_decoded = std::string();
+        m_buffer.release();
+        bufferChanged();
+        return true;
     }
 
     /*
      * \brief Main reader thread routine that reads all incoming messages and calls the associated callback
      */
     void handleRead() {
-        size_t filled = 0;
-        std::string input(INITIAL_BUFFER_SIZE, '\0');
+        size_t spins = 0;
+        // An own reader thread reads without turns
+        m_deficitBytes = SIZE_MAX;
+        m_deficitMessages = SIZE_MAX;
+        // In latency mode the buffer is pre-sized, the zero fill already faults in all pages
+        m_input = BufferPool::instance().acquire(std::max(m_baseSize, m_config.prefaultSize));
+        bufferChanged();
+        if (m_config.prefaultSize > 0) {
+            lockBuffer(m_input);
+            if (m_config.lockMemory) {
+                lockStack();
+            }
+        }
+        // Signals left pending by a previous reader whose wakeup was already consumed
+        drainSignals();
+        struct pollfd pfds[2] = { { m_transport->fd(), POLLIN, 0 }, { m_local ? m_local->eventFd() : -1, POLLIN, 0 } };
+        // With a local channel the named pipe is only read while it has data, after poll reported data and regularly during local traffic
+        bool fifoReady = true;
+        size_t rounds = 0;
         // Run until stopped
         while (!m_hasToStop) {
+            // A reader paused by the memory governor leaves the data in the pipe, its writers wait
+            if (!relieveMemory()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(PAUSE_CHECK_MS));
+                continue;
+            }
             // Read data if available
-            int read = ::read(m_fd, &input[filled], input.capacity() - filled);
-            // Check if some error other than missing writer exists
-            if (read == -1 && errno != ENXIO && errno != EAGAIN) {
-                throw std::logic_error("Reading from named pipe failed!");
-            } else if (read > 0) {
-                filled += read;
-                // Check buffer for messages
-                while (true) {
-                    // Check if message if fully read
-                    PipeMessage msg = nextMessage(input, filled);
-                    // If message is found
-                    if (msg.totalLength > 0) {
-                        // If callback is registered for the identifier, call it
-                        if (m_callbacks.find(msg.id) != m_callbacks.end()) {
-                            m_callbacks[msg.id](msg.content);
+            int read = fifoReady ? readTransport() : 0;
+            fifoReady = !m_local || read > 0 || ++rounds % LOCAL_FIFO_CHECK == 0;
+            if (read <= 0 && m_local && readLocal()) {
+                // Messages of writers in this process bypass the named pipe, frames in it were written before they switched
+                spins = 0;
+            } else if (read <= 0) {
+                // Spin for a while before sleeping, but wake up regularly to check for stop requests
+                if (spins++ >= m_config.spinBudget) {
+                    int ready = -1;
+                    if (!m_local) {
+                        if (m_transport->prepareSleep()) {
+                            ready = poll(pfds, 1, POLL_TIMEOUT_MS);
+                            m_transport->wakeUp();
                         }
-                        // Remove processed string part
-                        input = input.substr(msg.totalLength, std::string::npos);
-                        filled = filled - msg.totalLength;
+                    } else if (!m_transport->prepareSleep()) {
+                        // Data held back by the transport, e.g. the rest of a packet, is not reported by poll
+                        fifoReady = true;
                     } else {
-                        if (filled == input.size()) {
-                            // Increate buffer if no full message is retrieved and input is full
-                            input.resize(input.size() + INITIAL_BUFFER_SIZE);
+                        if (m_local->prepareSleep()) {
+                            ready = poll(pfds, 2, POLL_TIMEOUT_MS);
+                            m_local->wakeUp();
+                            fifoReady = (pfds[0].revents & POLLIN) != 0;
                         }
-                        break;
+                        m_transport->wakeUp();
                     }
+                    // Signals whose wakeup frame got lost, e.g. with a writer dying after raising them, stay pending and raise no further wakeup
+                    if (ready == 0) {
+                        drainSignals();
+                    }
+                    spins = 0;
                 }
+            } else {
+                spins = 0;
             }
         }
+        // Release locked receive buffer
+        if (m_config.prefaultSize > 0) {
+            unlockBuffer(m_input);
+        }
     }
 };
 
+// Pipe with escaped framing, adaptive receive buffer, locked writers and optional statistics
+using UnixPipe = BasicUnixPipe<>;
+
 #endif
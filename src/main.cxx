@@ -1,4 +1,5 @@
 #include "UnixPipe.hxx"
+#include "PipeCalibration.hxx"
 
 int main(int argc, char *argv[])
 {
@@ -18,5 +19,17 @@ int main(int argc, char *argv[])
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
     }
+    else if (argc > 1 && std::string(argv[1]) == "calibrate") {
+        PipeCalibration calibration(std::cerr);
+        PipeConfig config = calibration.run();
+        // Write recommended configuration to given file or stdout
+        if (argc > 2) {
+            std::ofstream file(argv[2]);
+            file << config.toString();
+            std::cerr << "Configuration written to " << argv[2] << ", load it by setting " << PipeConfig::ENVIRONMENT << "." << std::endl;
+        } else {
+            std::cout << config.toString();
+        }
+    }
     return 0;
 }
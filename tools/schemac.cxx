@@ -0,0 +1,460 @@
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Schema compiler generating encoders and in-place accessor views for UnixPipe messages.
+ *
+ * Usage: pipe-cxx-schemac <input.schema> <output.hxx>
+ *
+ * Schema language:
+ *
+ *     // Comment
+ *     namespace market;
+ *
+ *     struct Level {
+ *         f64 price;
+ *         u32 quantity;
+ *     }
+ *
+ *     message Book = "book" {
+ *         string symbol;
+ *         Level[] bids;
+ *         Level[] asks;
+ *     }
+ *
+ * Scalar types are bool, i8, i16, i32, i64, u8, u16, u32, u64, f32 and f64,
+ * further string, previously declared structs and messages and arrays (T[]) of
+ * all of them. A message is a struct with the message identifier used on the pipe,
+ * identifiers starting with __pipe. are reserved for internal messages.
+ *
+ * For each struct S the output contains the owning struct S, the view SView reading
+ * the encoded fields in place and the schema::Traits<S> specialization. The encoded
+ * structs carry offset tables (see SchemaRuntime.hxx), so every accessor and array
+ * element of a view is a constant time lookup. Messages
+ * additionally carry their identifier in S::ID and are sent and received with
+ * schema::write() and schema::subscribe() of SchemaRuntime.hxx.
+ */
+
+namespace {
+
+// Prefix of the identifiers of internal messages, see UnixPipe::RESERVED_PREFIX
+constexpr static const char* const RESERVED_PREFIX = "__pipe.";
+
+/*
+ * \brief Field of a struct
+ */
+struct Field {
+    // C++ type of the field without arrays
+    std::string base;
+    // True if the base type is a declared struct
+    bool user;
+    // Number of array dimensions
+    size_t dimensions;
+    // Field name
+    std::string name;
+
+    /*
+     * \brief C++ type of the field
+     * \param prefix Namespace prefix used for declared structs
+     */
+    std::string type(std::string const& prefix = "") const {
+        std::string result = user ? prefix + base : base;
+        for (size_t idx = 0; idx < dimensions; ++idx) {
+            result = "std::vector<" + result + ">";
+        }
+        return result;
+    }
+};
+
+/*
+ * \brief Struct or message declaration
+ */
+struct Struct {
+    // Name of the struct
+    std::string name;
+    // Message identifier, empty for plain structs
+    std::string id;
+    // Fields in declaration order
+    std::vector<Field> fields;
+};
+
+/*
+ * \brief Parsed schema
+ */
+struct Schema {
+    // Namespace (possibly nested with ::) of the generated code
+    std::string ns;
+    // Declarations in order
+    std::vector<Struct> structs;
+};
+
+/*
+ * \brief Tokenizer and recursive descent parser of the schema language
+ */
+class Parser {
+public:
+    Parser(std::string const& path, std::string const& text) : m_path(path), m_text(text), m_pos(0), m_line(1) {}
+
+    /*
+     * \brief Parse the whole schema, exits with an error message on failure
+     */
+    Schema parse() {
+        Schema schema;
+        std::set<std::string> known;
+        while (!peek().empty()) {
+            std::string keyword = next();
+            if (keyword == "namespace") {
+                schema.ns = next();
+                while (peek() == "::") {
+                    schema.ns += next() + next();
+                }
+                expect(";");
+            } else if (keyword == "struct" || keyword == "message") {
+                Struct decl;
+                decl.name = identifier();
+                if (known.count(decl.name) > 0) {
+                    fail("Duplicate declaration of " + decl.name + ".");
+                }
+                if (keyword == "message") {
+                    expect("=");
+                    decl.id = string();
+                    if (decl.id.compare(0, std::char_traits<char>::length(RESERVED_PREFIX), RESERVED_PREFIX) == 0) {
+                        fail("Message identifier '" + decl.id + "' starts with the reserved prefix '" + RESERVED_PREFIX + "'.");
+                    }
+                }
+                expect("{");
+                std::set<std::string> names;
+                while (peek() != "}") {
+                    Field field = type(known);
+                    field.name = identifier();
+                    if (!names.insert(field.name).second) {
+                        fail("Duplicate field " + field.name + " in " + decl.name + ".");
+                    }
+                    expect(";");
+                    decl.fields.push_back(field);
+                }
+                expect("}");
+                if (decl.fields.empty()) {
+                    fail(decl.name + " has no fields.");
+                }
+                known.insert(decl.name);
+                schema.structs.push_back(decl);
+            } else {
+                fail("Expected namespace, struct or message but found '" + keyword + "'.");
+            }
+        }
+        return schema;
+    }
+
+private:
+    std::string m_path;
+    std::string m_text;
+    size_t m_pos;
+    size_t m_line;
+
+    [[noreturn]] void fail(std::string const& message) {
+        std::cerr << m_path << ":" << m_line << ": error: " << message << std::endl;
+        std::exit(1);
+    }
+
+    /*
+     * \brief Skip whitespace and comments
+     */
+    void skip() {
+        while (m_pos < m_text.size()) {
+            if (m_text[m_pos] == '\n') {
+                ++m_line;
+                ++m_pos;
+            } else if (std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+                ++m_pos;
+            } else if (m_text.compare(m_pos, 2, "//") == 0) {
+                m_pos = m_text.find('\n', m_pos);
+                m_pos = (m_pos == std::string::npos) ? m_text.size() : m_pos;
+            } else {
+                break;
+            }
+        }
+    }
+
+    /*
+     * \brief Get next token without consuming it, empty at end of input
+     */
+    std::string peek() {
+        size_t pos = m_pos;
+        size_t line = m_line;
+        std::string token = next();
+        m_pos = pos;
+        m_line = line;
+        return token;
+    }
+
+    /*
+     * \brief Consume next token: identifier, string literal, :: or a single punctuation character
+     */
+    std::string next() {
+        skip();
+        if (m_pos >= m_text.size()) {
+            return "";
+        }
+        size_t start = m_pos;
+        char c = m_text[m_pos];
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            while (m_pos < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_')) {
+                ++m_pos;
+            }
+        } else if (c == '"') {
+            m_pos = m_text.find('"', m_pos + 1);
+            if (m_pos == std::string::npos) {
+                fail("Unterminated string.");
+            }
+            ++m_pos;
+        } else if (m_text.compare(m_pos, 2, "::") == 0) {
+            m_pos += 2;
+        } else {
+            ++m_pos;
+        }
+        return m_text.substr(start, m_pos - start);
+    }
+
+    void expect(std::string const& token) {
+        std::string found = next();
+        if (found != token) {
+            fail("Expected '" + token + "' but found '" + found + "'.");
+        }
+    }
+
+    std::string identifier() {
+        std::string token = next();
+        if (token.empty() || !(std::isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_')) {
+            fail("Expected identifier but found '" + token + "'.");
+        }
+        return token;
+    }
+
+    std::string string() {
+        std::string token = next();
+        if (token.size() < 2 || token[0] != '"') {
+            fail("Expected string but found '" + token + "'.");
+        }
+        return token.substr(1, token.size() - 2);
+    }
+
+    /*
+     * \brief Parse the type of a field
+     */
+    Field type(std::set<std::string> const& known) {
+        static std::map<std::string, std::string> const scalars = {
+            { "bool", "bool" }, { "i8", "int8_t" }, { "i16", "int16_t" }, { "i32", "int32_t" }, { "i64", "int64_t" },
+            { "u8", "uint8_t" }, { "u16", "uint16_t" }, { "u32", "uint32_t" }, { "u64", "uint64_t" },
+            { "f32", "float" }, { "f64", "double" }, { "string", "std::string" },
+        };
+        std::string name = identifier();
+        Field field;
+        field.dimensions = 0;
+        auto scalar = scalars.find(name);
+        if (scalar != scalars.end()) {
+            field.base = scalar->second;
+            field.user = false;
+        } else if (known.count(name) > 0) {
+            field.base = name;
+            field.user = true;
+        } else {
+            fail("Unknown type " + name + ", structs have to be declared before use.");
+        }
+        while (peek() == "[") {
+            expect("[");
+            expect("]");
+            ++field.dimensions;
+        }
+        return field;
+    }
+};
+
+/*
+ * \brief Writes the generated header
+ */
+class Generator {
+public:
+    explicit Generator(Schema const& schema) : m_schema(schema), m_prefix(schema.ns.empty() ? "::" : "::" + schema.ns + "::") {}
+
+    std::string generate() {
+        m_out << "// Generated by pipe-cxx-schemac, do not edit.\n"
+              << "#pragma once\n\n"
+              << "#include <cstdint>\n#include <string>\n#include <string_view>\n#include <vector>\n\n"
+              << "#include \"SchemaRuntime.hxx\"\n";
+        // Owning structs and view declarations
+        openNamespace();
+        for (Struct const& decl : m_schema.structs) {
+            declare(decl);
+        }
+        closeNamespace();
+        // Traits
+        m_out << "\nnamespace schema {\n";
+        for (Struct const& decl : m_schema.structs) {
+            traits(decl);
+        }
+        m_out << "\n}\n";
+        // View definitions
+        openNamespace();
+        for (Struct const& decl : m_schema.structs) {
+            define(decl);
+        }
+        closeNamespace();
+        return m_out.str();
+    }
+
+private:
+    Schema const& m_schema;
+    std::string m_prefix;
+    std::ostringstream m_out;
+
+    void openNamespace() {
+        if (!m_schema.ns.empty()) {
+            m_out << "\nnamespace " << m_schema.ns << " {\n";
+        }
+    }
+
+    void closeNamespace() {
+        if (!m_schema.ns.empty()) {
+            m_out << "\n}\n";
+        }
+    }
+
+    /*
+     * \brief Quote a string as C++ string literal, escaping quotes, backslashes and non-printable characters
+     */
+    static std::string literal(std::string const& text) {
+        std::string quoted = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+                quoted += c;
+            } else if (std::isprint(static_cast<unsigned char>(c))) {
+                quoted += c;
+            } else {
+                // Octal escapes end after three digits, unlike hexadecimal ones
+                char escaped[5];
+                std::snprintf(escaped, sizeof(escaped), "\\%03o", static_cast<unsigned char>(c));
+                quoted += escaped;
+            }
+        }
+        return quoted + "\"";
+    }
+
+    /*
+     * \brief Fully qualified traits of a field type
+     */
+    std::string traitsOf(Field const& field) {
+        return "::schema::Traits<" + field.type(m_prefix) + ">";
+    }
+
+    void declare(Struct const& decl) {
+        m_out << "\nstruct " << decl.name << " {\n";
+        if (!decl.id.empty()) {
+            m_out << "    // Message identifier\n"
+                  << "    constexpr static const char* const ID = " << literal(decl.id) << ";\n\n";
+        }
+        for (Field const& field : decl.fields) {
+            m_out << "    " << field.type() << " " << field.name << "{};\n";
+        }
+        m_out << "};\n\n"
+              << "/*\n * \\brief In-place view of an encoded " << decl.name << ", valid as long as the encoded data\n */\n"
+              << "class " << decl.name << "View {\n"
+              << "public:\n"
+              << "    explicit " << decl.name << "View(char const* data) : m_data(data) {}\n\n";
+        for (Field const& field : decl.fields) {
+            m_out << "    " << traitsOf(field) << "::View " << field.name << "() const;\n";
+        }
+        m_out << "\nprivate:\n"
+              << "    char const* m_data;\n";
+        m_out << "};\n";
+    }
+
+    void traits(Struct const& decl) {
+        std::string type = m_prefix + decl.name;
+        m_out << "\ntemplate<>\n"
+              << "struct Traits<" << type << "> {\n"
+              << "    using View = " << type << "View;\n"
+              << "    using Layout = ::schema::Layout<";
+        for (size_t idx = 0; idx < decl.fields.size(); ++idx) {
+            m_out << (idx > 0 ? ", " : "") << decl.fields[idx].type(m_prefix);
+        }
+        m_out << ">;\n"
+              << "    static constexpr size_t const FIXED_SIZE = Layout::FIXED_SIZE;\n\n"
+              << "    static size_t encodedSize(" << type << " const& value) {\n"
+              << "        return Layout::encodedSize(" << values(decl) << ");\n"
+              << "    }\n\n"
+              << "    static char* encode(" << type << " const& value, char* out) {\n"
+              << "        return Layout::encode(out, " << values(decl) << ");\n"
+              << "    }\n\n"
+              << "    static size_t wireSize(char const* data) {\n"
+              << "        return Layout::wireSize(data);\n"
+              << "    }\n\n"
+              << "    static size_t validate(char const* data, size_t available) {\n"
+              << "        return Layout::validate(data, available);\n"
+              << "    }\n\n"
+              << "    static View view(char const* data) {\n"
+              << "        return View(data);\n"
+              << "    }\n"
+              << "};\n";
+    }
+
+    /*
+     * \brief Comma separated list of all fields of value
+     */
+    std::string values(Struct const& decl) {
+        std::string list;
+        for (size_t idx = 0; idx < decl.fields.size(); ++idx) {
+            list += (idx > 0 ? ", value." : "value.") + decl.fields[idx].name;
+        }
+        return list;
+    }
+
+    void define(Struct const& decl) {
+        std::string view = decl.name + "View";
+        for (size_t idx = 0; idx < decl.fields.size(); ++idx) {
+            Field const& field = decl.fields[idx];
+            m_out << "\ninline " << traitsOf(field) << "::View " << view << "::" << field.name << "() const {\n"
+                  << "    return ::schema::Traits<" << m_prefix << decl.name << ">::Layout::field<" << idx << ">(m_data);\n"
+                  << "}\n";
+        }
+    }
+};
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.schema> <output.hxx>" << std::endl;
+        return 1;
+    }
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "Unable to open " << argv[1] << "." << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+    Schema schema = Parser(argv[1], text.str()).parse();
+    std::string generated = Generator(schema).generate();
+    // Only touch the output if it changed to avoid needless rebuilds
+    std::ifstream existing(argv[2]);
+    std::stringstream current;
+    current << existing.rdbuf();
+    if (!existing || current.str() != generated) {
+        std::ofstream output(argv[2]);
+        output << generated;
+        if (!output) {
+            std::cerr << "Unable to write " << argv[2] << "." << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}